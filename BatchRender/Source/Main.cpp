@@ -0,0 +1,1019 @@
+#include <JuceHeader.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include "../../Source/PluginProcessor.h"
+
+// Headless batch renderer: runs audio files through the plugin with a saved state, on a thread pool.
+//
+// Long files are cut into chunks that render in parallel. Each chunk starts its own processor a
+// little early (the pre-roll) so the reverb and filters have converged by the time its first kept
+// sample comes out, and renders a few milliseconds past its end. The last chunk of a file to finish
+// stitches the file together: every seam is checked against the previous chunk's overlap, chunks
+// that miss the tolerance are re-rendered with twice the pre-roll, and the overlap is crossfaded.
+// Audio is streamed block by block throughout, so memory use doesn't grow with file length.
+namespace
+{
+    juce::CriticalSection logLock;
+
+    void log (const juce::String& message)
+    {
+        const juce::ScopedLock sl (logLock);
+        std::cout << message << std::endl;
+    }
+
+    struct Settings
+    {
+        juce::MemoryBlock state;        // getStateInformation() blob, --param overrides already applied
+        juce::File outputDirectory;     // next to each input when not set
+        int blockSize = 1024;
+        double chunkSeconds = 30.0;
+        double prerollSeconds = 0.0;
+        double tailSeconds = 0.0;
+        double overlapSeconds = 0.01;
+        float tolerance = 0.0f;         // peak seam error, linear
+    };
+
+    struct Chunk
+    {
+        // Timeline positions in samples: the chunk owns [start, end) and renders [start, renderEnd).
+        juce::int64 start = 0, end = 0, renderEnd = 0, preroll = 0;
+        juce::File tempFile;
+    };
+
+    struct FileJob
+    {
+        juce::File input, output;
+        juce::AudioFormat* outputFormat = nullptr;
+        double sampleRate = 44100.0;
+        int numChannels = 2, bitsPerSample = 24, overlap = 0;
+        bool floatingPoint = false;
+        juce::int64 totalLength = 0;    // input plus the requested tail
+        std::vector<Chunk> chunks;
+
+        std::atomic<int> chunksLeft { 0 };
+        std::atomic<bool> failed { false };
+        juce::CriticalSection errorLock;
+        juce::String error;
+
+        float worstSeam = 0.0f;
+        int retries = 0;
+        juce::uint32 startTime = 0;
+
+        void fail (const juce::String& message)
+        {
+            const juce::ScopedLock sl (errorLock);
+            if (! failed.exchange (true))
+                error = message;
+        }
+    };
+
+    int pickBitDepth (juce::AudioFormat& format, int sourceBits)
+    {
+        const auto depths = format.getPossibleBitDepths();
+        int best = 0;
+        for (auto depth : depths)
+            if (depth <= sourceBits && depth > best)
+                best = depth;
+        return best > 0 ? best : (depths.isEmpty() ? 24 : depths.getFirst());
+    }
+
+    juce::String formatDecibels (float gain)
+    {
+        return juce::String (juce::Decibels::gainToDecibels (gain, -200.0f), 1) + " dB";
+    }
+
+    //==============================================================================
+    class BatchRenderer
+    {
+    public:
+        BatchRenderer (Settings s, int numThreads)
+            : settings (std::move (s)),
+              pool (juce::ThreadPoolOptions{}.withThreadName ("LOUDER render").withNumberOfThreads (numThreads))
+        {
+            formats.registerBasicFormats();
+            wavFormat = formats.findFormatForFileExtension ("wav");
+        }
+
+        bool addFile (const juce::File& input)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+            if (reader == nullptr) {
+                log ("Can't read " + input.getFullPathName());
+                return false;
+            }
+            if (reader->numChannels < 1 || reader->numChannels > 2 || reader->lengthInSamples <= 0) {
+                log ("Skipping " + input.getFileName() + ": only non-empty mono or stereo files are supported");
+                return false;
+            }
+
+            auto job = std::make_unique<FileJob>();
+            job->input = input;
+            job->sampleRate = reader->sampleRate;
+            job->numChannels = (int) reader->numChannels;
+            job->totalLength = reader->lengthInSamples + (juce::int64) std::llround (settings.tailSeconds * job->sampleRate);
+
+            // Same format and depth as the source where the format can write it; WAV otherwise.
+            job->outputFormat = formats.findFormatForFileExtension (input.getFileExtension());
+            if (job->outputFormat == nullptr || ! job->outputFormat->canDoStereo() || ! job->outputFormat->canDoMono())
+                job->outputFormat = wavFormat;
+
+            job->bitsPerSample = pickBitDepth (*job->outputFormat, (int) reader->bitsPerSample);
+            job->floatingPoint = reader->usesFloatingPointData && job->outputFormat == wavFormat && job->bitsPerSample == 32;
+
+            const auto extension = job->outputFormat == wavFormat ? juce::String (".wav") : input.getFileExtension();
+            const auto directory = settings.outputDirectory == juce::File() ? input.getParentDirectory() : settings.outputDirectory;
+            job->output = directory.getChildFile (input.getFileNameWithoutExtension() + "_louder" + extension);
+
+            // A file shorter than two chunks renders in one piece; otherwise the last chunk takes the remainder.
+            const auto chunkLength = juce::jmax ((juce::int64) 1, (juce::int64) std::llround (settings.chunkSeconds * job->sampleRate));
+            const auto numChunks = settings.chunkSeconds > 0.0 ? juce::jmax ((juce::int64) 1, job->totalLength / chunkLength) : (juce::int64) 1;
+            const auto preroll = (juce::int64) std::llround (settings.prerollSeconds * job->sampleRate);
+            job->overlap = juce::jmax (64, juce::roundToInt (settings.overlapSeconds * job->sampleRate));
+
+            for (juce::int64 k = 0; k < numChunks; ++k)
+            {
+                Chunk chunk;
+                chunk.start = k * chunkLength;
+                chunk.end = (k + 1 == numChunks) ? job->totalLength : (k + 1) * chunkLength;
+                chunk.renderEnd = chunk.end + (k + 1 < numChunks ? job->overlap : 0);
+                chunk.preroll = juce::jmin (chunk.start, preroll);
+                if (numChunks > 1)
+                    chunk.tempFile = job->output.getSiblingFile ("." + job->output.getFileNameWithoutExtension() + ".part" + juce::String (k) + ".wav");
+                job->chunks.push_back (chunk);
+            }
+
+            jobs.push_back (std::move (job));
+            return true;
+        }
+
+        // Returns true when every file rendered.
+        bool run()
+        {
+            filesLeft = (int) jobs.size();
+            if (filesLeft == 0)
+                return false;
+
+            for (auto& job : jobs)
+            {
+                job->chunksLeft = (int) job->chunks.size();
+                job->startTime = juce::Time::getMillisecondCounter();
+                log ("Rendering " + job->input.getFileName() + " in " + juce::String ((int) job->chunks.size()) + " chunk(s)");
+            }
+
+            // File by file, so files finish (and free their temp space) roughly in order instead of
+            // all at the very end.
+            for (auto& job : jobs)
+                for (size_t k = 0; k < job->chunks.size(); ++k)
+                    pool.addJob ([this, j = job.get(), k] { renderChunk (*j, k); });
+
+            allDone.wait (-1);
+
+            bool allOk = true;
+            for (auto& job : jobs)
+                allOk = allOk && ! job->failed;
+            return allOk;
+        }
+
+    private:
+        void renderChunk (FileJob& job, size_t index)
+        {
+            if (! job.failed)
+            {
+                auto& chunk = job.chunks[index];
+                const auto result = job.chunks.size() == 1
+                                        ? renderToFile (job, chunk, job.output, *job.outputFormat, job.bitsPerSample, job.floatingPoint)
+                                        : renderToFile (job, chunk, chunk.tempFile, *wavFormat, 32, true);
+                if (result.failed())
+                    job.fail (result.getErrorMessage());
+            }
+
+            if (--job.chunksLeft == 0)
+            {
+                finishFile (job);
+                if (--filesLeft == 0)
+                    allDone.signal();
+            }
+        }
+
+        void finishFile (FileJob& job)
+        {
+            if (! job.failed && job.chunks.size() > 1) {
+                const auto result = stitch (job);
+                if (result.failed())
+                    job.fail (result.getErrorMessage());
+            }
+
+            for (auto& chunk : job.chunks)
+                if (chunk.tempFile != juce::File())
+                    chunk.tempFile.deleteFile();
+
+            if (job.failed) {
+                job.output.deleteFile();
+                log ("FAILED " + job.input.getFileName() + ": " + job.error);
+                return;
+            }
+
+            juce::String seams;
+            if (job.chunks.size() > 1)
+                seams << ", worst seam " << formatDecibels (job.worstSeam) << ", " << job.retries << " re-render(s)";
+
+            log ("Wrote " + job.output.getFullPathName() + " ("
+                 + juce::String ((juce::Time::getMillisecondCounter() - job.startTime) / 1000.0, 1) + " s" + seams + ")");
+        }
+
+        std::unique_ptr<juce::AudioFormatWriter> createWriter (juce::AudioFormat& format, const juce::File& file, const FileJob& job,
+                                                               int bitsPerSample, bool floatingPoint)
+        {
+            if (! file.deleteFile())
+                return {};
+
+            auto fileStream = std::make_unique<juce::FileOutputStream> (file);
+            if (! fileStream->openedOk())
+                return {};
+
+            auto options = juce::AudioFormatWriterOptions{}.withSampleRate (job.sampleRate)
+                                                           .withNumChannels (job.numChannels)
+                                                           .withBitsPerSample (bitsPerSample);
+            if (floatingPoint)
+                options = options.withSampleFormat (juce::AudioFormatWriterOptions::SampleFormat::floatingPoint);
+
+            std::unique_ptr<juce::OutputStream> stream (std::move (fileStream));
+            return format.createWriterFor (stream, options);
+        }
+
+        juce::Result renderToFile (const FileJob& job, const Chunk& chunk, const juce::File& file, juce::AudioFormat& format,
+                                   int bitsPerSample, bool floatingPoint)
+        {
+            auto writer = createWriter (format, file, job, bitsPerSample, floatingPoint);
+            if (writer == nullptr)
+                return juce::Result::fail ("can't write " + file.getFullPathName());
+
+            return renderRange (job, chunk, *writer);
+        }
+
+        // Renders the chunk's timeline range into 'writer', warming up over the pre-roll first and
+        // dropping the processor's latency so the output lines up with the input.
+        juce::Result renderRange (const FileJob& job, const Chunk& chunk, juce::AudioFormatWriter& writer)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (job.input));
+            if (reader == nullptr)
+                return juce::Result::fail ("can't reopen " + job.input.getFullPathName());
+
+            NewLouderSaturator_Feb21AudioProcessor processor;
+
+            const auto channelSet = job.numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add (channelSet);
+            layout.outputBuses.add (channelSet);
+            if (! processor.setBusesLayout (layout))
+                return juce::Result::fail ("unsupported channel layout");
+
+            processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+            processor.setNonRealtime (true);
+            processor.setRateAndBufferSizeDetails (job.sampleRate, settings.blockSize);
+            processor.prepareToPlay (job.sampleRate, settings.blockSize);
+
+            const juce::int64 latency = processor.getLatencySamples();
+            juce::AudioBuffer<float> buffer (job.numChannels, settings.blockSize);
+            juce::MidiBuffer midi;
+            bool written = true;
+
+            // What goes in at 'position' comes out 'latency' samples later. The reader zero-fills
+            // past the end of the file, which is what renders the tail.
+            for (auto position = chunk.start - chunk.preroll; written && position - latency < chunk.renderEnd;)
+            {
+                const int numSamples = (int) juce::jmin ((juce::int64) settings.blockSize, chunk.renderEnd + latency - position);
+                juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), job.numChannels, numSamples);
+
+                reader->read (&block, 0, numSamples, position, true, job.numChannels > 1);
+                processor.processBlock (block, midi);
+                midi.clear();
+
+                const auto outputStart = position - latency;
+                const auto keepFrom = juce::jmax (chunk.start, outputStart);
+                const auto keepTo   = juce::jmin (chunk.renderEnd, outputStart + numSamples);
+                if (keepTo > keepFrom)
+                    written = writer.writeFromAudioSampleBuffer (block, (int) (keepFrom - outputStart), (int) (keepTo - keepFrom));
+
+                position += numSamples;
+            }
+
+            processor.releaseResources();
+            return written ? juce::Result::ok() : juce::Result::fail ("write error");
+        }
+
+        juce::Result stitch (FileJob& job)
+        {
+            auto writer = createWriter (*job.outputFormat, job.output, job, job.bitsPerSample, job.floatingPoint);
+            if (writer == nullptr)
+                return juce::Result::fail ("can't write " + job.output.getFullPathName());
+
+            const int overlap = job.overlap;
+            juce::AudioBuffer<float> previousTail (job.numChannels, overlap), head (job.numChannels, overlap);
+            juce::AudioBuffer<float> buffer (job.numChannels, settings.blockSize);
+
+            for (size_t k = 0; k < job.chunks.size(); ++k)
+            {
+                auto& chunk = job.chunks[k];
+                std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (chunk.tempFile));
+                juce::int64 position = 0;   // in the temp file, which starts at chunk.start
+
+                if (k > 0)
+                {
+                    // Both chunks rendered [start, start + overlap); if the later one hadn't settled
+                    // yet, warm it up for longer. A chunk whose pre-roll reaches back to the start of
+                    // the file has seen the whole history, so that's as good as it gets.
+                    for (;;)
+                    {
+                        if (reader == nullptr)
+                            return juce::Result::fail ("can't read " + chunk.tempFile.getFullPathName());
+
+                        reader->read (&head, 0, overlap, 0, true, job.numChannels > 1);
+
+                        float seam = 0.0f;
+                        for (int ch = 0; ch < job.numChannels; ++ch)
+                            for (int i = 0; i < overlap; ++i)
+                                seam = juce::jmax (seam, std::abs (head.getSample (ch, i) - previousTail.getSample (ch, i)));
+
+                        if (seam <= settings.tolerance || chunk.preroll >= chunk.start) {
+                            job.worstSeam = juce::jmax (job.worstSeam, seam);
+                            break;
+                        }
+
+                        chunk.preroll = juce::jmin (chunk.start, juce::jmax (chunk.preroll * 2, (juce::int64) settings.blockSize));
+                        ++job.retries;
+                        log (job.input.getFileName() + ": seam " + juce::String ((int) k) + " off by " + formatDecibels (seam)
+                             + ", re-rendering with " + juce::String ((double) chunk.preroll / job.sampleRate, 2) + " s pre-roll");
+
+                        reader.reset();
+                        const auto result = renderToFile (job, chunk, chunk.tempFile, *wavFormat, 32, true);
+                        if (result.failed())
+                            return result;
+                        reader = std::unique_ptr<juce::AudioFormatReader> (formats.createReaderFor (chunk.tempFile));
+                    }
+
+                    for (int ch = 0; ch < job.numChannels; ++ch)
+                        for (int i = 0; i < overlap; ++i) {
+                            const float fade = ((float) i + 0.5f) / (float) overlap;
+                            head.setSample (ch, i, previousTail.getSample (ch, i) + fade * (head.getSample (ch, i) - previousTail.getSample (ch, i)));
+                        }
+
+                    if (! writer->writeFromAudioSampleBuffer (head, 0, overlap))
+                        return juce::Result::fail ("write error");
+                    position = overlap;
+                }
+                else if (reader == nullptr)
+                {
+                    return juce::Result::fail ("can't read " + chunk.tempFile.getFullPathName());
+                }
+
+                const auto bodyEnd = chunk.end - chunk.start;
+                while (position < bodyEnd)
+                {
+                    const int numSamples = (int) juce::jmin ((juce::int64) settings.blockSize, bodyEnd - position);
+                    reader->read (&buffer, 0, numSamples, position, true, job.numChannels > 1);
+                    if (! writer->writeFromAudioSampleBuffer (buffer, 0, numSamples))
+                        return juce::Result::fail ("write error");
+                    position += numSamples;
+                }
+
+                if (k + 1 < job.chunks.size())
+                    reader->read (&previousTail, 0, overlap, bodyEnd, true, job.numChannels > 1);
+
+                reader.reset();
+                chunk.tempFile.deleteFile();
+            }
+
+            return writer->flush() ? juce::Result::ok() : juce::Result::fail ("write error");
+        }
+
+        Settings settings;
+        juce::AudioFormatManager formats;
+        juce::AudioFormat* wavFormat = nullptr;
+        std::vector<std::unique_ptr<FileJob>> jobs;
+        std::atomic<int> filesLeft { 0 };
+        juce::WaitableEvent allDone;
+        juce::ThreadPool pool;
+
+        JUCE_DECLARE_NON_COPYABLE (BatchRenderer)
+    };
+
+    //==============================================================================
+    // Loads the state file (the plugin's binary blob or the XML inside it), applies the --param
+    // overrides and hands back the resulting blob, plus the tail length at those settings.
+    juce::Result prepareState (const juce::File& stateFile, const juce::StringPairArray& overrides,
+                               juce::MemoryBlock& state, double& tailSeconds)
+    {
+        NewLouderSaturator_Feb21AudioProcessor processor;
+
+        if (stateFile != juce::File())
+        {
+            juce::MemoryBlock data;
+            if (auto xml = juce::parseXML (stateFile))
+                juce::AudioProcessor::copyXmlToBinary (*xml, data);
+            else if (! stateFile.loadFileAsData (data))
+                return juce::Result::fail ("can't read " + stateFile.getFullPathName());
+
+            processor.setStateInformation (data.getData(), (int) data.getSize());
+        }
+
+        for (auto& id : overrides.getAllKeys())
+        {
+            auto* parameter = processor.apvts.getParameter (id);
+            if (parameter == nullptr)
+                return juce::Result::fail ("unknown parameter '" + id + "'");
+            parameter->setValueNotifyingHost (parameter->getValueForText (overrides[id]));
+        }
+
+        processor.getStateInformation (state);
+        tailSeconds = processor.getTailLengthSeconds();
+        return juce::Result::ok();
+    }
+
+    // --measure-reverb-storage: sends the same noise burst through the reverb with 32-bit and 16-bit
+    // delay lines and prints how far the difference sits below the tail while it decays. The numbers
+    // in Docs/ReverbStorage.md come from this.
+    int measureReverbStorage()
+    {
+        juce::ScopedNoDenormals noDenormals;
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512, windowSize = 4800;
+
+        struct Setting { const char* name; float roomSize, damping; };
+        const Setting settings[] = { { "Room, decay 50%",  0.25f, 0.30f },
+                                     { "Plate, decay 70%", 0.49f, 0.55f },
+                                     { "Hall, decay 50%",  0.75f, 0.40f },
+                                     { "Hall, decay 100%", 1.00f, 0.00f } };
+
+        for (const auto& setting : settings)
+        {
+            RoomReverb::Parameters params;
+            params.roomSize = setting.roomSize;
+            params.damping = setting.damping;
+            params.wetLevel = 1.0f / 3.0f;  // unity wet gain after the reverb's internal scaling
+            params.dryLevel = 0.0f;
+            params.width = 1.0f;
+
+            RoomReverb reverbs[2];
+            const RoomReverb::Storage storages[2] = { RoomReverb::Storage::float32, RoomReverb::Storage::float16 };
+            for (int r = 0; r < 2; ++r) {
+                reverbs[r].setParameters (params);
+                reverbs[r].setSampleRate (sampleRate, RoomReverb::defaultGroups, storages[r]);
+            }
+
+            const double rt60 = RoomReverb::getDecayTimeSeconds (params, 60.0);
+            const int burstSamples = (int) sampleRate / 2;
+            const int totalSamples = burstSamples + (int) (sampleRate * juce::jmin (40.0, 2.0 * rt60));
+
+            std::printf ("\n%s: RT60 %.2f s, 0.5 s white noise burst at -6 dBFS\n", setting.name, rt60);
+            std::printf ("  %8s %12s %12s %12s\n", "time", "tail dBFS", "error dBFS", "error/tail");
+
+            juce::Random random (1);
+            std::vector<float> buffers[2][2];
+            for (auto& pair : buffers)
+                for (auto& b : pair)
+                    b.resize ((size_t) blockSize);
+
+            double tailEnergy = 0.0, errorEnergy = 0.0, worstRatio = -400.0;
+            float peakError = 0.0f;
+            int windowFill = 0, nextThreshold = -20;
+
+            for (int start = 0; start < totalSamples; start += blockSize)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    const bool inBurst = start + i < burstSamples;
+                    const float l = inBurst ? (random.nextFloat() - 0.5f) : 0.0f;
+                    const float r = inBurst ? (random.nextFloat() - 0.5f) : 0.0f;
+                    for (auto& pair : buffers) {
+                        pair[0][(size_t) i] = l;
+                        pair[1][(size_t) i] = r;
+                    }
+                }
+
+                for (int r = 0; r < 2; ++r)
+                    reverbs[r].processStereo (buffers[r][0].data(), buffers[r][1].data(), blockSize);
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    for (int ch = 0; ch < 2; ++ch) {
+                        const float reference = buffers[0][ch][(size_t) i];
+                        const float error = buffers[1][ch][(size_t) i] - reference;
+                        tailEnergy += (double) reference * reference;
+                        errorEnergy += (double) error * error;
+                        peakError = juce::jmax (peakError, std::abs (error));
+                    }
+
+                    if (++windowFill < windowSize)
+                        continue;
+
+                    const int sample = start + i + 1;
+                    const double tailDb = 10.0 * std::log10 (tailEnergy / (2.0 * windowSize) + 1.0e-30);
+                    const double errorDb = 10.0 * std::log10 (errorEnergy / (2.0 * windowSize) + 1.0e-30);
+
+                    // Only count windows where there's still a tail to hear; below -100 dBFS the
+                    // processor's own tail detection switches the chain off anyway.
+                    if (sample > burstSamples && tailDb > -100.0)
+                        worstRatio = juce::jmax (worstRatio, errorDb - tailDb);
+
+                    if (sample <= burstSamples + windowSize || (sample > burstSamples && tailDb < nextThreshold && nextThreshold >= -120)) {
+                        std::printf ("  %7.2fs %12.1f %12.1f %12.1f\n", sample / sampleRate, tailDb, errorDb, errorDb - tailDb);
+                        if (sample > burstSamples + windowSize)
+                            while (tailDb < nextThreshold) nextThreshold -= 20;
+                    }
+
+                    tailEnergy = errorEnergy = 0.0;
+                    windowFill = 0;
+                }
+            }
+
+            std::printf ("  worst error/tail while the tail is above -100 dBFS: %.1f dB, peak error %.1f dBFS\n",
+                         worstRatio, juce::Decibels::gainToDecibels (peakError, -200.0f));
+        }
+
+        RoomReverb sizes[2];
+        sizes[0].setSampleRate (sampleRate, RoomReverb::defaultGroups, RoomReverb::Storage::float32);
+        sizes[1].setSampleRate (sampleRate, RoomReverb::defaultGroups, RoomReverb::Storage::float16);
+        std::printf ("\nDelay memory at 48 kHz: %d bytes (32-bit), %d bytes (16-bit)\n",
+                     (int) sizes[0].getHeapBytes(), (int) sizes[1].getHeapBytes());
+        return 0;
+    }
+
+    // --selftest-kernels: runs the same random blocks through every kernel variant this CPU supports
+    // and compares each with the generic one, at lengths that exercise every vector tail. Then times
+    // them on 512-sample blocks, processed in place over and over (the settings keep that bounded).
+    // Last, the drive kernels get NaN and infinite input. Exits non-zero if any variant is off by
+    // more than 1e-5 (-100 dBFS), or a table curve lets a non-finite sample through.
+    int selfTestKernels()
+    {
+        juce::ScopedNoDenormals noDenormals;
+        constexpr float tolerance = 1.0e-5f;
+        constexpr int timedSamples = 512, timedRuns = 20000;
+        const int lengths[] = { 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 64, 255, 1027 };
+
+        using Kernel = std::function<void (const Kernels::Table&, float* left, float* right, const float* dry, int numSamples)>;
+        std::vector<std::pair<juce::String, Kernel>> kernels;
+        kernels.push_back ({ "gain ramp", [] (const Kernels::Table& t, float* l, float*, const float*, int n) { t.gainRamp (l, n, 1.0f, 0.5f); } });
+        kernels.push_back ({ "mix ramp",  [] (const Kernels::Table& t, float* l, float*, const float* d, int n) { t.mixRamp (l, d, n, 0.2f, 0.8f); } });
+        kernels.push_back ({ "width",     [] (const Kernels::Table& t, float* l, float* r, const float*, int n) { t.width (l, r, n, 0.6f); } });
+
+        // Reads 7 samples past the last peak it writes.
+        kernels.push_back ({ "true peak", [] (const Kernels::Table& t, float* l, float*, const float* d, int n) { t.truePeak (d, l, juce::jmax (0, n - 7)); } });
+
+        for (int m = 0; m < (int) Saturation::Model::numModels; ++m)
+            kernels.push_back ({ "drive " + Saturation::modelNames[m],
+                                 [m] (const Kernels::Table& t, float* l, float*, const float*, int n) { t.saturate[(size_t) m] (l, n, 2.5f); } });
+
+        const auto& reference = Kernels::getTable (Kernels::Isa::generic);
+        juce::Random random (1);
+        auto fill = [&random] (std::vector<float>& v) { for (auto& x : v) x = (random.nextFloat() * 2.0f - 1.0f) * 4.0f; };
+        bool passed = true;
+
+        std::printf ("Best supported: %s\n\n", Kernels::getIsaName (Kernels::getBestIsa()));
+        std::printf ("  %-8s %-16s %12s %10s %14s\n", "isa", "kernel", "max error", "result", "ns/sample");
+
+        for (int i = 0; i < (int) Kernels::Isa::numIsas; ++i)
+        {
+            const auto isa = (Kernels::Isa) i;
+            if (! Kernels::isSupported (isa))
+                continue;
+
+            const auto& table = Kernels::getTable (isa);
+
+            for (const auto& [name, kernel] : kernels)
+            {
+                float maxError = 0.0f;
+
+                for (int length : lengths)
+                {
+                    std::vector<float> left ((size_t) length), right ((size_t) length), dry ((size_t) length);
+                    fill (left);
+                    fill (right);
+                    fill (dry);
+                    auto expectedLeft = left, expectedRight = right;
+
+                    kernel (table, left.data(), right.data(), dry.data(), length);
+                    kernel (reference, expectedLeft.data(), expectedRight.data(), dry.data(), length);
+
+                    for (size_t s = 0; s < (size_t) length; ++s)
+                        maxError = juce::jmax (maxError, std::abs (left[s] - expectedLeft[s]), std::abs (right[s] - expectedRight[s]));
+                }
+
+                std::vector<float> left ((size_t) timedSamples), right ((size_t) timedSamples), dry ((size_t) timedSamples);
+                fill (left);
+                fill (right);
+                fill (dry);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                for (int run = 0; run < timedRuns; ++run)
+                    kernel (table, left.data(), right.data(), dry.data(), timedSamples);
+                const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+                const bool ok = maxError <= tolerance;
+                passed = passed && ok;
+                std::printf ("  %-8s %-16s %12.3g %10s %14.3f\n", Kernels::getIsaName (isa), name.toRawUTF8(), (double) maxError,
+                             ok ? "ok" : "FAILED", seconds * 1.0e9 / ((double) timedRuns * timedSamples));
+            }
+        }
+
+        // NaN and infinities, mixed with ordinary samples so they land in vector lanes and tails alike.
+        // The table curves must turn them into finite output (an unclamped NaN would index outside the
+        // table); every variant must agree with the generic one, NaN for NaN.
+        const float nonFinite[] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+                                    -std::numeric_limits<float>::infinity(), 0.3f, -1.0e30f };
+
+        std::printf ("\n  %-8s %-16s %12s %10s\n", "isa", "NaN/Inf input", "max error", "result");
+
+        for (int i = 0; i < (int) Kernels::Isa::numIsas; ++i)
+        {
+            const auto isa = (Kernels::Isa) i;
+            if (! Kernels::isSupported (isa))
+                continue;
+
+            for (int m = 0; m < (int) Saturation::Model::numModels; ++m)
+            {
+                const bool tableCurve = m <= (int) Saturation::Model::Tape;
+                float maxError = 0.0f;
+                bool ok = true;
+
+                for (int length : lengths)
+                {
+                    std::vector<float> data ((size_t) length);
+                    for (size_t s = 0; s < data.size(); ++s)
+                        data[s] = nonFinite[s % std::size (nonFinite)];
+
+                    auto expected = data;
+                    Kernels::getTable (isa).saturate[(size_t) m] (data.data(), length, 2.5f);
+                    reference.saturate[(size_t) m] (expected.data(), length, 2.5f);
+
+                    for (size_t s = 0; s < data.size(); ++s)
+                    {
+                        if (std::isnan (data[s]) || std::isnan (expected[s]))
+                            ok = ok && std::isnan (data[s]) == std::isnan (expected[s]);
+                        else
+                            maxError = juce::jmax (maxError, std::abs (data[s] - expected[s]));
+
+                        if (tableCurve)
+                            ok = ok && std::isfinite (data[s]) && std::abs (data[s]) <= 1.0f;
+                    }
+                }
+
+                ok = ok && maxError <= tolerance;
+                passed = passed && ok;
+                std::printf ("  %-8s %-16s %12.3g %10s\n", Kernels::getIsaName (isa), ("drive " + Saturation::modelNames[m]).toRawUTF8(),
+                             (double) maxError, ok ? "ok" : "FAILED");
+            }
+        }
+
+        std::printf ("\n%s\n", passed ? "All variants match the generic kernels." : "Some variants FAILED.");
+        return passed ? 0 : 1;
+    }
+
+    //==============================================================================
+    // --diagnose-callback: the standalone app's callback diagnostics without a GUI and, by default,
+    // without audio hardware. The processor's CallbackMonitor times every processBlock against its
+    // deadline while a null device calls it once a period from a realtime thread, the way a driver
+    // would. The input is a file, looped, or noise peaking at -18 dBFS. With --device the run goes through the
+    // default device of that type instead (ALSA, JACK, CoreAudio, Windows Audio, ASIO...).
+    struct DiagnoseSettings
+    {
+        juce::MemoryBlock state;
+        juce::String deviceType;        // empty: the null device
+        juce::File input;
+        double sampleRate = 0.0;        // 0: 48 kHz, or the device's current rate
+        int blockSize = 0;              // 0: 256, or the device's current buffer size
+        double seconds = 30.0;
+        int maxOverruns = -1;           // more overruns or xruns than this fails the run; -1 never fails
+    };
+
+    // Stands in for a sound card. If processing falls a whole period behind, the slot it missed is
+    // dropped and counted as an xrun, as a real device would, and the schedule restarts from now.
+    class NullDevice : private juce::Thread
+    {
+    public:
+        NullDevice (juce::AudioProcessor& p, const juce::AudioBuffer<float>& source, int block, double rate)
+            : juce::Thread ("LOUDER null device"), processor (p), input (source), blockSize (block), sampleRate (rate) {}
+
+        // Blocks until done. Returns false if the thread didn't get realtime priority (no rtprio
+        // limit on Linux, say); it then runs at the highest normal priority, and the report shows it.
+        bool play (double seconds)
+        {
+            numBlocks = (juce::int64) std::ceil (seconds * sampleRate / blockSize);
+            const bool realtime = startRealtimeThread (juce::Thread::RealtimeOptions{}.withPeriodMs (1000.0 * blockSize / sampleRate));
+            if (! realtime)
+                startThread (juce::Thread::Priority::highest);
+
+            waitForThreadToExit (-1);
+            return realtime;
+        }
+
+        int getXRunCount() const noexcept { return xruns; }
+
+    private:
+        void run() override
+        {
+            using Clock = std::chrono::steady_clock;
+            const auto period = std::chrono::duration_cast<Clock::duration> (std::chrono::duration<double> (blockSize / sampleRate));
+
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            juce::MidiBuffer midi;
+            int position = 0;
+            auto due = Clock::now();
+
+            for (juce::int64 i = 0; i < numBlocks && ! threadShouldExit(); ++i)
+            {
+                for (int done = 0; done < blockSize;)
+                {
+                    const int n = juce::jmin (blockSize - done, input.getNumSamples() - position);
+                    for (int ch = 0; ch < 2; ++ch)
+                        buffer.copyFrom (ch, done, input, juce::jmin (ch, input.getNumChannels() - 1), position, n);
+                    done += n;
+                    position = (position + n) % input.getNumSamples();
+                }
+
+                processor.processBlock (buffer, midi);
+                midi.clear();
+
+                due += period;
+                const auto now = Clock::now();
+                if (now >= due + period) {
+                    ++xruns;
+                    due = now;
+                }
+                std::this_thread::sleep_until (due);
+            }
+        }
+
+        juce::AudioProcessor& processor;
+        const juce::AudioBuffer<float>& input;
+        const int blockSize;
+        const double sampleRate;
+        juce::int64 numBlocks = 0;
+        int xruns = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (NullDevice)
+    };
+
+    int diagnoseCallback (const DiagnoseSettings& settings)
+    {
+        NewLouderSaturator_Feb21AudioProcessor processor;
+        processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+        processor.callbackMonitor.setEnabled (true);
+
+        juce::String deviceName;
+        int blockSize = 0, xruns = -1;
+        double sampleRate = 0.0, cpuUsage = -1.0;
+        bool realtime = true;
+
+        if (settings.deviceType.isEmpty())
+        {
+            // Up to a minute of the file is looped; the rate doesn't matter for timing.
+            sampleRate = settings.sampleRate > 0.0 ? settings.sampleRate : 48000.0;
+            blockSize = settings.blockSize > 0 ? settings.blockSize : 256;
+            juce::AudioBuffer<float> input;
+
+            if (settings.input != juce::File())
+            {
+                juce::AudioFormatManager formats;
+                formats.registerBasicFormats();
+                std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (settings.input));
+                if (reader == nullptr || reader->lengthInSamples <= 0) {
+                    log ("Error: can't read " + settings.input.getFullPathName());
+                    return 1;
+                }
+
+                const int length = (int) juce::jmin (reader->lengthInSamples, (juce::int64) (60.0 * reader->sampleRate));
+                input.setSize ((int) juce::jlimit (1u, 2u, reader->numChannels), length);
+                reader->read (&input, 0, length, 0, true, input.getNumChannels() > 1);
+                deviceName = "null device, input " + settings.input.getFileName();
+            }
+            else
+            {
+                juce::Random random (1);
+                input.setSize (2, (int) sampleRate);
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < input.getNumSamples(); ++i)
+                        input.setSample (ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.125f);
+                deviceName = "null device, noise input";
+            }
+
+            processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            NullDevice device (processor, input, blockSize, sampleRate);
+            realtime = device.play (settings.seconds);
+            xruns = device.getXRunCount();
+            processor.releaseResources();
+        }
+        else
+        {
+            juce::AudioDeviceManager deviceManager;
+            auto error = deviceManager.initialise (2, 2, nullptr, true);
+
+            if (error.isEmpty())
+            {
+                deviceManager.setCurrentAudioDeviceType (settings.deviceType, true);
+                auto setup = deviceManager.getAudioDeviceSetup();
+                if (settings.sampleRate > 0.0) setup.sampleRate = settings.sampleRate;
+                if (settings.blockSize > 0)    setup.bufferSize = settings.blockSize;
+                error = deviceManager.setAudioDeviceSetup (setup, true);
+            }
+
+            auto* device = deviceManager.getCurrentAudioDevice();
+            if (error.isEmpty() && (device == nullptr || device->getTypeName() != settings.deviceType))
+            {
+                juce::StringArray types;
+                for (auto* type : deviceManager.getAvailableDeviceTypes())
+                    types.add (type->getTypeName());
+                error = "no " + settings.deviceType + " device (available types: " + types.joinIntoString (", ") + ")";
+            }
+
+            if (error.isNotEmpty()) {
+                log ("Error: " + error);
+                return 1;
+            }
+
+            deviceName = device->getTypeName() + " / " + device->getName();
+            blockSize = device->getCurrentBufferSizeSamples();
+            sampleRate = device->getCurrentSampleRate();
+
+            juce::AudioProcessorPlayer player;
+            player.setProcessor (&processor);
+            deviceManager.addAudioCallback (&player);
+            juce::Thread::sleep ((int) (settings.seconds * 1000.0));
+            cpuUsage = deviceManager.getCpuUsage();
+            xruns = deviceManager.getXRunCount();
+            deviceManager.removeAudioCallback (&player);
+            player.setProcessor (nullptr);
+        }
+
+        const auto stats = processor.callbackMonitor.getStats();
+        const auto thread = CallbackMonitor::describe (processor.callbackMonitor.getThreadInfo());
+
+        std::printf ("Device:    %s\n", deviceName.toRawUTF8());
+        std::printf ("Buffer:    %d samples at %.0f Hz, %.2f ms budget\n", blockSize, sampleRate, 1000.0 * blockSize / sampleRate);
+        std::printf ("Thread:    %s%s\n", thread.toRawUTF8(), realtime ? "" : " (realtime priority was refused)");
+        std::printf ("Callbacks: %s\n", CallbackMonitor::summarise (stats).toRawUTF8());
+        std::printf ("Xruns:     %d reported by the device", xruns);
+        if (cpuUsage >= 0.0)
+            std::printf (", device CPU %.0f%%", cpuUsage * 100.0);
+        std::printf ("\n\nShare of the budget used per callback:\n%s", CallbackMonitor::formatHistogram (stats).toRawUTF8());
+
+        if (stats.callbacks == 0) {
+            std::printf ("\nNo callbacks were made.\n");
+            return 1;
+        }
+
+        if (settings.maxOverruns >= 0 && (stats.overruns > (std::uint64_t) settings.maxOverruns || xruns > settings.maxOverruns)) {
+            std::printf ("\nFAILED: more than %d overruns or xruns.\n", settings.maxOverruns);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: LouderBatchRender [options] <input files...>\n"
+                     "  --state <file>        plugin state (saved blob or its XML)\n"
+                     "  --param <id>=<value>  override a parameter, e.g. --param reverbType=Hall\n"
+                     "  --out <dir>           output directory (default: next to each input)\n"
+                     "  --jobs <n>            worker threads (default: number of CPUs)\n"
+                     "  --chunk <seconds>     chunk length for parallel rendering, 0 = whole files (default 30)\n"
+                     "  --preroll <seconds>   warm-up before each chunk (default: twice the reverb's RT60, at least 0.5)\n"
+                     "  --tolerance <dB>      largest allowed seam error before a chunk is re-rendered (default -90)\n"
+                     "  --tail <seconds>      silence rendered after the end of each file (default 0)\n"
+                     "  --block <samples>     processing block size (default 1024)\n"
+                     "\n"
+                     "       LouderBatchRender --measure-reverb-storage\n"
+                     "  prints the 16-bit reverb storage noise measurements (see Docs/ReverbStorage.md)\n"
+                     "\n"
+                     "       LouderBatchRender --selftest-kernels\n"
+                     "  checks every SIMD kernel variant this CPU supports against the generic code and times them\n"
+                     "\n"
+                     "       LouderBatchRender --diagnose-callback [options] [input file]\n"
+                     "  times every audio callback against its deadline, as the standalone app's DIAG panel does\n"
+                     "  --device <type>       audio device type to run on, e.g. ALSA or JACK (default: a null device)\n"
+                     "  --rate <Hz>           sample rate (default 48000, or the device's)\n"
+                     "  --block <samples>     buffer size (default 256, or the device's)\n"
+                     "  --seconds <n>         run length (default 30)\n"
+                     "  --max-overruns <n>    exit non-zero on more overruns or xruns than this\n"
+                     "  --state, --param      as above; the null device loops the input file, or plays noise\n";
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor and its parameter tree expect JUCE's message manager to exist.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Settings settings;
+    juce::File stateFile;
+    juce::StringPairArray overrides;
+    juce::Array<juce::File> inputs;
+    DiagnoseSettings diagnoseSettings;
+    bool diagnose = false;
+    int numThreads = juce::SystemStats::getNumCpus(), blockSize = 0;
+    double prerollSeconds = -1.0, toleranceDb = -90.0;
+
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    if (argc == 2 && juce::String (argv[1]) == "--measure-reverb-storage")
+        return measureReverbStorage();
+
+    if (argc == 2 && juce::String (argv[1]) == "--selftest-kernels")
+        return selfTestKernels();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg (argv[i]);
+        const bool hasValue = i + 1 < argc;
+        auto value = [&] { return hasValue ? juce::String (argv[++i]) : juce::String(); };
+
+        if (arg == "--diagnose-callback") {
+            diagnose = true;
+            continue;
+        }
+
+        if (arg.startsWith ("--") && ! hasValue) {
+            printUsage();
+            return 1;
+        }
+
+        if      (arg == "--state")     stateFile = cwd.getChildFile (value());
+        else if (arg == "--out")       settings.outputDirectory = cwd.getChildFile (value());
+        else if (arg == "--jobs")      numThreads = juce::jmax (1, value().getIntValue());
+        else if (arg == "--chunk")     settings.chunkSeconds = juce::jmax (0.0, value().getDoubleValue());
+        else if (arg == "--preroll")   prerollSeconds = juce::jmax (0.0, value().getDoubleValue());
+        else if (arg == "--tolerance") toleranceDb = value().getDoubleValue();
+        else if (arg == "--tail")      settings.tailSeconds = juce::jmax (0.0, value().getDoubleValue());
+        else if (arg == "--block")     blockSize = juce::jlimit (16, 65536, value().getIntValue());
+        else if (arg == "--device")    diagnoseSettings.deviceType = value();
+        else if (arg == "--rate")      diagnoseSettings.sampleRate = juce::jlimit (8000.0, 768000.0, value().getDoubleValue());
+        else if (arg == "--seconds")   diagnoseSettings.seconds = juce::jmax (0.1, value().getDoubleValue());
+        else if (arg == "--max-overruns") diagnoseSettings.maxOverruns = juce::jmax (0, value().getIntValue());
+        else if (arg == "--param")
+        {
+            const auto assignment = value();
+            overrides.set (assignment.upToFirstOccurrenceOf ("=", false, false).trim(),
+                           assignment.fromFirstOccurrenceOf ("=", false, false).trim());
+        }
+        else if (arg.startsWith ("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            inputs.add (cwd.getChildFile (arg));
+        }
+    }
+
+    if (diagnose ? inputs.size() > 1 : inputs.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    double tailSeconds = 0.0;
+    const auto stateResult = prepareState (stateFile, overrides, settings.state, tailSeconds);
+    if (stateResult.failed()) {
+        log ("Error: " + stateResult.getErrorMessage());
+        return 1;
+    }
+
+    if (diagnose)
+    {
+        diagnoseSettings.state = settings.state;
+        diagnoseSettings.input = inputs.isEmpty() ? juce::File() : inputs.getFirst();
+        diagnoseSettings.blockSize = blockSize;
+        return diagnoseCallback (diagnoseSettings);
+    }
+
+    settings.blockSize = blockSize > 0 ? juce::jmax (32, blockSize) : 1024;
+
+    // A frozen reverb never forgets anything, so chunks couldn't converge: render files whole.
+    if (! std::isfinite (tailSeconds)) {
+        log ("Reverb is frozen; rendering each file in one piece");
+        settings.chunkSeconds = 0.0;
+    }
+
+    settings.prerollSeconds = prerollSeconds >= 0.0 ? prerollSeconds : juce::jmax (0.5, std::isfinite (tailSeconds) ? 2.0 * tailSeconds : 0.0);
+    settings.tolerance = juce::Decibels::decibelsToGain ((float) toleranceDb, -400.0f);
+
+    if (settings.outputDirectory != juce::File() && ! settings.outputDirectory.createDirectory()) {
+        log ("Error: can't create " + settings.outputDirectory.getFullPathName());
+        return 1;
+    }
+
+    BatchRenderer renderer (std::move (settings), numThreads);
+
+    bool allAdded = true;
+    for (auto& input : inputs)
+        allAdded = renderer.addFile (input) && allAdded;
+
+    const bool allRendered = renderer.run();
+    return allAdded && allRendered ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#if JUCE_LINUX
+ #include <sys/resource.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+// Times every processBlock call against its budget, numSamples / sampleRate. It keeps a histogram of
+// the share of the budget each call used and counts the calls that went over it (overruns). It also
+// counts calls that started late, more than 1.5 periods after the previous one: the device skipped
+// a buffer or the audio thread wasn't scheduled in time. The audio thread's scheduling class and
+// priority are read on the first call after every reset.
+//
+// Only the plugin's share of the device callback is timed. The driver's and the wrapper's share
+// shows up in AudioDeviceManager::getCpuUsage(), and the device's own xrun count is the final word
+// on dropouts. Off by default: the standalone app and LouderBatchRender --diagnose-callback turn it on.
+class CallbackMonitor
+{
+public:
+    // Bucket b counts calls that used [5b, 5b + 5)% of their budget; the last one takes 200% and up.
+    static constexpr int bucketsPerBudget = 20;
+    static constexpr int numBuckets = bucketsPerBudget * 2 + 1;
+
+    // Gaps longer than restartSeconds are the stream being stopped and started, not a late call.
+    static constexpr double latePeriods = 1.5;
+    static constexpr double restartSeconds = 1.0;
+
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept                 { return enabled.load (std::memory_order_relaxed); }
+
+    // From prepareToPlay, never while a callback can run. New device settings start fresh statistics.
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate.store (newSampleRate, std::memory_order_relaxed);
+        requestReset();
+    }
+
+    // Any thread. Applied at the start of the next callback.
+    void requestReset() noexcept { resetRequested.store (true, std::memory_order_release); }
+
+    // Audio thread: put one at the top of processBlock, so early returns are timed too.
+    struct Scope
+    {
+        Scope (CallbackMonitor& m, int n) noexcept
+            : monitor (m.isEnabled() ? &m : nullptr), numSamples (n), start (monitor != nullptr ? monitor->begin() : 0) {}
+
+        ~Scope() noexcept
+        {
+            if (monitor != nullptr)
+                monitor->end (start, numSamples);
+        }
+
+        CallbackMonitor* monitor;
+        int numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    //==============================================================================
+    // Any thread. Every counter has a single writer (the audio thread), so a reader may see a
+    // callback half-committed; that's fine for a readout.
+    struct Stats
+    {
+        std::uint64_t callbacks = 0, overruns = 0, late = 0;
+        float meanLoad = 0.0f, p50Load = 0.0f, p99Load = 0.0f, maxLoad = 0.0f;
+        float worstIntervalPeriods = 0.0f;      // longest gap between two call starts, in periods
+        int minBlockSize = 0, maxBlockSize = 0;
+        double sampleRate = 0.0;
+        std::array<std::uint32_t, (size_t) numBuckets> buckets {};
+    };
+
+    Stats getStats() const noexcept
+    {
+        Stats stats;
+        for (int b = 0; b < numBuckets; ++b) {
+            stats.buckets[(size_t) b] = buckets[b].load (std::memory_order_relaxed);
+            stats.callbacks += stats.buckets[(size_t) b];
+        }
+
+        stats.sampleRate = sampleRate.load (std::memory_order_relaxed);
+        if (stats.callbacks == 0)
+            return stats;
+
+        stats.overruns = overruns.load (std::memory_order_relaxed);
+        stats.late = late.load (std::memory_order_relaxed);
+        stats.meanLoad = (float) (totalLoad.load (std::memory_order_relaxed) / (double) stats.callbacks);
+        stats.maxLoad = maxLoad.load (std::memory_order_relaxed);
+        stats.worstIntervalPeriods = worstInterval.load (std::memory_order_relaxed);
+        stats.minBlockSize = minBlockSize.load (std::memory_order_relaxed);
+        stats.maxBlockSize = maxBlockSize.load (std::memory_order_relaxed);
+
+        // Percentiles are bucket upper edges, so they round up to the next 5%.
+        std::uint64_t seen = 0;
+        for (int b = 0; b < numBuckets; ++b) {
+            seen += stats.buckets[(size_t) b];
+            const float edge = (float) (b + 1) / (float) bucketsPerBudget;
+            if (stats.p50Load == 0.0f && seen * 2 >= stats.callbacks)     stats.p50Load = edge;
+            if (stats.p99Load == 0.0f && seen * 100 >= stats.callbacks * 99) stats.p99Load = edge;
+        }
+
+        return stats;
+    }
+
+    // Scheduling of the thread that made the last reset's first call. 'policy' is a SCHED_* value
+    // and 'nice' only means something for the time-sharing classes (Linux only).
+    struct ThreadInfo
+    {
+        bool known = false;
+        int policy = 0, priority = 0, nice = 0;
+    };
+
+    ThreadInfo getThreadInfo() const noexcept
+    {
+        ThreadInfo info;
+        info.known = threadKnown.load (std::memory_order_acquire);
+        info.policy = threadPolicy.load (std::memory_order_relaxed);
+        info.priority = threadPriority.load (std::memory_order_relaxed);
+        info.nice = threadNice.load (std::memory_order_relaxed);
+        return info;
+    }
+
+    static juce::String describe (const ThreadInfo& info)
+    {
+       #if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+        if (! info.known)
+            return "not seen yet";
+
+        switch (info.policy)
+        {
+            case SCHED_FIFO:  return "SCHED_FIFO, priority " + juce::String (info.priority);
+            case SCHED_RR:    return "SCHED_RR, priority " + juce::String (info.priority);
+           #if JUCE_LINUX
+            case SCHED_BATCH: return "SCHED_BATCH, nice " + juce::String (info.nice) + " (not realtime)";
+            case SCHED_IDLE:  return "SCHED_IDLE (not realtime)";
+            case SCHED_OTHER: return "SCHED_OTHER, nice " + juce::String (info.nice) + " (not realtime)";
+           #else
+            case SCHED_OTHER: return "SCHED_OTHER, priority " + juce::String (info.priority);
+           #endif
+            default:          return "policy " + juce::String (info.policy) + ", priority " + juce::String (info.priority);
+        }
+       #else
+        juce::ignoreUnused (info);
+        return "not available on this platform";
+       #endif
+    }
+
+    // One line for logs: "128 smp @ 48000 Hz, 5320 calls, load mean 12% p50 15% p99 35% max 61%, ...".
+    static juce::String summarise (const Stats& stats)
+    {
+        auto percent = [] (float load) { return juce::String (juce::roundToInt (load * 100.0f)) + "%"; };
+        const auto blockSize = stats.minBlockSize == stats.maxBlockSize ? juce::String (stats.maxBlockSize)
+                                                                        : juce::String (stats.minBlockSize) + "-" + juce::String (stats.maxBlockSize);
+
+        return blockSize + " smp @ " + juce::String (stats.sampleRate, 0) + " Hz, "
+             + juce::String ((juce::int64) stats.callbacks) + " calls, load mean " + percent (stats.meanLoad)
+             + " p50 " + percent (stats.p50Load) + " p99 " + percent (stats.p99Load) + " max " + percent (stats.maxLoad)
+             + ", " + juce::String ((juce::int64) stats.overruns) + " overruns, " + juce::String ((juce::int64) stats.late)
+             + " late (worst gap " + juce::String (stats.worstIntervalPeriods, 2) + " periods)";
+    }
+
+    // The non-empty part of the histogram, one row per bucket with a bar scaled to the largest.
+    static juce::String formatHistogram (const Stats& stats)
+    {
+        int first = numBuckets, last = -1;
+        std::uint32_t largest = 1;
+        for (int b = 0; b < numBuckets; ++b)
+            if (stats.buckets[(size_t) b] > 0) {
+                first = juce::jmin (first, b);
+                last = b;
+                largest = juce::jmax (largest, stats.buckets[(size_t) b]);
+            }
+
+        juce::String text;
+        for (int b = first; b <= last; ++b)
+        {
+            const auto count = stats.buckets[(size_t) b];
+            const auto range = b == numBuckets - 1 ? juce::String ("200%+")
+                                                   : juce::String (b * 5) + "-" + juce::String (b * 5 + 5) + "%";
+            text << "  " << range.paddedLeft (' ', 8) << juce::String ((juce::int64) count).paddedLeft (' ', 10) << "  "
+                 << juce::String::repeatedString ("#", (int) std::ceil (40.0 * count / largest)) << "\n";
+        }
+        return text;
+    }
+
+private:
+    juce::int64 begin() noexcept
+    {
+        if (resetRequested.exchange (false, std::memory_order_acquire)) {
+            clear();
+            captureThreadInfo();
+        }
+
+        const auto now = juce::Time::getHighResolutionTicks();
+
+        if (lastStart != 0)
+        {
+            const double interval = juce::Time::highResolutionTicksToSeconds (now - lastStart);
+            const float periods = (float) (interval / lastPeriod);
+
+            if (interval < restartSeconds)
+            {
+                if (periods > latePeriods)
+                    late.store (late.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                if (periods > worstInterval.load (std::memory_order_relaxed))
+                    worstInterval.store (periods, std::memory_order_relaxed);
+            }
+        }
+
+        lastStart = now;
+        return now;
+    }
+
+    void end (juce::int64 start, int numSamples) noexcept
+    {
+        const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        lastPeriod = juce::jmax (1, numSamples) / sampleRate.load (std::memory_order_relaxed);
+
+        const float load = (float) (seconds / lastPeriod);
+        const int b = juce::jlimit (0, numBuckets - 1, (int) (load * bucketsPerBudget));
+
+        buckets[b].store (buckets[b].load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totalLoad.store (totalLoad.load (std::memory_order_relaxed) + load, std::memory_order_relaxed);
+        if (load > 1.0f)
+            overruns.store (overruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (load > maxLoad.load (std::memory_order_relaxed))
+            maxLoad.store (load, std::memory_order_relaxed);
+
+        if (numSamples < minBlockSize.load (std::memory_order_relaxed) || minBlockSize.load (std::memory_order_relaxed) == 0)
+            minBlockSize.store (numSamples, std::memory_order_relaxed);
+        if (numSamples > maxBlockSize.load (std::memory_order_relaxed))
+            maxBlockSize.store (numSamples, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept
+    {
+        for (auto& b : buckets) b.store (0, std::memory_order_relaxed);
+        overruns.store (0, std::memory_order_relaxed);
+        late.store (0, std::memory_order_relaxed);
+        totalLoad.store (0.0, std::memory_order_relaxed);
+        maxLoad.store (0.0f, std::memory_order_relaxed);
+        worstInterval.store (0.0f, std::memory_order_relaxed);
+        minBlockSize.store (0, std::memory_order_relaxed);
+        maxBlockSize.store (0, std::memory_order_relaxed);
+        lastStart = 0;
+    }
+
+    // A couple of system calls, once per reset; the callback they land in is timed after them.
+    void captureThreadInfo() noexcept
+    {
+       #if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+        int policy = 0;
+        sched_param param {};
+        if (pthread_getschedparam (pthread_self(), &policy, &param) != 0)
+            return;
+
+        threadPolicy.store (policy, std::memory_order_relaxed);
+        threadPriority.store (param.sched_priority, std::memory_order_relaxed);
+        #if JUCE_LINUX
+         threadNice.store (getpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid)), std::memory_order_relaxed);
+        #endif
+        threadKnown.store (true, std::memory_order_release);
+       #endif
+    }
+
+    std::atomic<bool> enabled { false }, resetRequested { true };
+    std::atomic<double> sampleRate { 44100.0 };
+    double lastPeriod = 1.0;
+    juce::int64 lastStart = 0;
+
+    std::atomic<std::uint32_t> buckets[numBuckets] {};
+    std::atomic<std::uint64_t> overruns { 0 }, late { 0 };
+    std::atomic<double> totalLoad { 0.0 };
+    std::atomic<float> maxLoad { 0.0f }, worstInterval { 0.0f };
+    std::atomic<int> minBlockSize { 0 }, maxBlockSize { 0 };
+
+    std::atomic<bool> threadKnown { false };
+    std::atomic<int> threadPolicy { 0 }, threadPriority { 0 }, threadNice { 0 };
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Watches how much of each block's deadline (numSamples / sampleRate) processBlock takes, and under
+// sustained pressure steps down through quality tiers; when the headroom comes back it steps up
+// again, more reluctantly. The processor decides what a tier means (currently: one reverb comb
+// group less per tier, which RoomReverb fades out and back in without a click).
+//
+// The load statistic is the 95th percentile over a sliding window of about half a second, kept as a
+// histogram so each block costs a few dozen adds and nothing is ever allocated on the audio thread.
+class CpuGovernor
+{
+public:
+    static constexpr int maxWindowBlocks = 512;
+
+    // Step down when the slowest 5% of blocks use more than this much of their deadline, step back
+    // up only after a few windows in a row below the lower mark.
+    static constexpr float stepDownLoad = 0.5f;
+    static constexpr float stepUpLoad = 0.25f;
+    static constexpr int calmWindowsToStepUp = 4;
+
+    // From prepareToPlay, never while process() can run.
+    void prepare (double sampleRate, int blockSize) noexcept
+    {
+        windowBlocks = juce::jlimit (16, maxWindowBlocks, (int) (0.5 * sampleRate / juce::jmax (1, blockSize)));
+        reset();
+    }
+
+    // Audio thread. Back to full quality with an empty window.
+    void reset() noexcept
+    {
+        clearWindow();
+        calmBlocks = 0;
+        tier = 0;
+        load = 0.0f;
+    }
+
+    // Audio thread, once per processed block. Returns the tier to run the next block at.
+    int process (double blockSeconds, double deadlineSeconds) noexcept
+    {
+        const float blockLoad = deadlineSeconds > 0.0 ? (float) (blockSeconds / deadlineSeconds) : 0.0f;
+        const auto bucket = (std::uint8_t) juce::jlimit (0, numBuckets - 1, (int) (blockLoad * bucketsPerDeadline));
+
+        if (filled == windowBlocks)
+            --counts[history[(size_t) next]];
+        else
+            ++filled;
+
+        history[(size_t) next] = bucket;
+        ++counts[bucket];
+        next = (next + 1) % windowBlocks;
+
+        load = getPercentile (0.95f);
+
+        if (filled < windowBlocks)
+            return tier;
+
+        if (load > stepDownLoad)
+        {
+            calmBlocks = 0;
+            if (tier < maxTier) {
+                ++tier;
+                clearWindow();
+            }
+        }
+        else if (load < stepUpLoad && tier > 0)
+        {
+            if (++calmBlocks >= windowBlocks * calmWindowsToStepUp) {
+                --tier;
+                calmBlocks = 0;
+                clearWindow();
+            }
+        }
+        else
+        {
+            calmBlocks = 0;
+        }
+
+        return tier;
+    }
+
+    void setMaxTier (int newMaxTier) noexcept
+    {
+        maxTier = juce::jmax (0, newMaxTier);
+        tier = juce::jmin (tier, maxTier);
+    }
+
+    int getTier() const noexcept     { return tier; }
+
+    // 95th percentile block time as a fraction of the deadline, over what's in the window so far.
+    float getLoad() const noexcept   { return load; }
+
+private:
+    // 2.5% of the deadline per bucket; the last one also takes every overrun beyond 120%.
+    static constexpr int bucketsPerDeadline = 40;
+    static constexpr int numBuckets = bucketsPerDeadline * 6 / 5;
+
+    void clearWindow() noexcept
+    {
+        for (auto& c : counts) c = 0;
+        filled = 0;
+        next = 0;
+    }
+
+    float getPercentile (float fraction) const noexcept
+    {
+        const int above = juce::jmax (1, (int) ((1.0f - fraction) * (float) filled));
+        int seen = 0;
+
+        for (int b = numBuckets - 1; b > 0; --b)
+            if ((seen += counts[b]) >= above)
+                return (float) (b + 1) / (float) bucketsPerDeadline;
+
+        return 1.0f / (float) bucketsPerDeadline;
+    }
+
+    std::array<std::uint8_t, (size_t) maxWindowBlocks> history {};
+    std::array<int, (size_t) numBuckets> counts {};
+    int windowBlocks = 64, filled = 0, next = 0;
+    int calmBlocks = 0;
+    int tier = 0, maxTier = 0;
+    float load = 0.0f;
+};
@@ -0,0 +1,657 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SaturationCurves.h"
+
+// The plugin is built for each platform's baseline (SSE2 on x86-64, NEON on 64-bit ARM), so wider
+// units are only used through functions compiled for them and picked at runtime. GCC and Clang need
+// a target attribute on such functions; MSVC accepts the intrinsics anywhere.
+#if JUCE_INTEL && (JUCE_MSVC || JUCE_GCC || JUCE_CLANG)
+ #include <immintrin.h>
+ #define LOUDER_KERNELS_X86 1
+ #if JUCE_MSVC
+  #define LOUDER_TARGET_F16C
+  #define LOUDER_TARGET_AVX2
+  #define LOUDER_TARGET_AVX512
+ #else
+  #define LOUDER_TARGET_F16C   __attribute__ ((target ("f16c")))
+  #define LOUDER_TARGET_AVX2   __attribute__ ((target ("avx2")))
+  #define LOUDER_TARGET_AVX512 __attribute__ ((target ("avx512f")))
+ #endif
+#elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+ #include <arm_neon.h>
+ #define LOUDER_KERNELS_NEON 1
+#endif
+
+// The per-sample loops of the gain, mix, width and drive stages and of the limiter's true-peak
+// detector, in one variant per instruction set.
+// prepareToPlay takes the widest one the CPU supports; LouderBatchRender --selftest-kernels checks
+// every supported variant against the generic one.
+//
+// Every variant does the same arithmetic in the same order as the generic code, and the AVX2 and
+// SSE2 ones match it bit for bit. Where the target has FMA (AVX-512, ARM64) the compiler may fuse a
+// multiply and an add, which moves results by an ulp or so; the self-test allows 1e-5 (-100 dBFS).
+namespace Kernels
+{
+    enum class Isa { generic = 0, sse2, avx2, avx512, neon, numIsas };
+
+    using GainFunction  = void (*) (float* data, int numSamples, float startGain, float endGain) noexcept;
+    using MixFunction   = void (*) (float* wet, const float* dry, int numSamples, float startMix, float endMix) noexcept;
+    using WidthFunction = void (*) (float* left, float* right, int numSamples, float width) noexcept;
+    using PeakFunction  = void (*) (const float* input, float* peaks, int numSamples) noexcept;
+
+    struct Table
+    {
+        Isa isa;
+        GainFunction gainRamp;      // data *= gain, ramping linearly from startGain towards endGain
+        MixFunction mixRamp;        // wet = wet * mix + dry * (1 - mix), mix ramping the same way
+        WidthFunction width;        // scales the side signal
+        PeakFunction truePeak;      // peaks = max (peaks, |input[i + 4]| and 3 points before it); reads numSamples + 7
+        std::array<Saturation::BlockFunction, (size_t) Saturation::Model::numModels> saturate;   // Quality::Table curves
+    };
+
+    inline const char* getIsaName (Isa isa) noexcept
+    {
+        static const char* const names[] = { "generic", "sse2", "avx2", "avx512", "neon" };
+        return names[juce::jlimit (0, (int) Isa::numIsas - 1, (int) isa)];
+    }
+
+    //==============================================================================
+    // CPU features, detected once. F16C is used by RoomReverb's 16-bit delay lines.
+    inline bool cpuHasF16C() noexcept
+    {
+       #if LOUDER_KERNELS_X86 && JUCE_MSVC
+        static const bool supported = juce::SystemStats::hasAVX2();
+       #elif LOUDER_KERNELS_X86
+        static const bool supported = __builtin_cpu_supports ("f16c");
+       #else
+        static const bool supported = false;
+       #endif
+        return supported;
+    }
+
+    inline bool isSupported (Isa isa) noexcept
+    {
+        switch (isa)
+        {
+            case Isa::generic: return true;
+           #if LOUDER_KERNELS_X86 && JUCE_MSVC
+            case Isa::sse2:    return true;
+            case Isa::avx2:    { static const bool supported = juce::SystemStats::hasAVX2(); return supported; }
+            case Isa::avx512:  { static const bool supported = juce::SystemStats::hasAVX512F(); return supported; }
+           #elif LOUDER_KERNELS_X86
+            case Isa::sse2:    return true;
+            case Isa::avx2:    { static const bool supported = __builtin_cpu_supports ("avx2"); return supported; }
+            case Isa::avx512:  { static const bool supported = __builtin_cpu_supports ("avx512f"); return supported; }
+           #elif LOUDER_KERNELS_NEON
+            case Isa::neon:    return true;
+           #endif
+            default:           return false;
+        }
+    }
+
+    //==============================================================================
+    namespace detail
+    {
+        // Scalar forms, also used for the tail of every vector loop. The ramp is evaluated in
+        // closed form (start + step * i) so a vector lane computes exactly what the scalar loop does.
+        inline void gainRamp (float* data, int start, int numSamples, float startGain, float step) noexcept
+        {
+            for (int i = start; i < numSamples; ++i)
+                data[i] *= startGain + step * (float) i;
+        }
+
+        inline void mixRamp (float* wet, const float* dry, int start, int numSamples, float startMix, float step) noexcept
+        {
+            for (int i = start; i < numSamples; ++i) {
+                const float mix = startMix + step * (float) i;
+                wet[i] = wet[i] * mix + dry[i] * (1.0f - mix);
+            }
+        }
+
+        inline void width (float* left, float* right, int start, int numSamples, float width) noexcept
+        {
+            for (int i = start; i < numSamples; ++i) {
+                const float mid = (left[i] + right[i]) * 0.5f;
+                const float side = (left[i] - right[i]) * 0.5f * width;
+                left[i] = mid + side;
+                right[i] = mid - side;
+            }
+        }
+
+        template <Saturation::Model M>
+        void saturate (float* data, int start, int numSamples, float gain) noexcept
+        {
+            for (int i = start; i < numSamples; ++i)
+                data[i] = Saturation::Curve<M>::process (data[i] * gain);
+        }
+
+        // Hann-windowed sinc for the points 1/4, 2/4 and 3/4 of the way from input[i + 3] to
+        // input[i + 4], each normalised to unity gain at DC: a 4x oversampled peak estimate.
+        constexpr int truePeakTaps = 8, truePeakPhases = 3;
+        using TruePeakTaps = std::array<std::array<float, (size_t) truePeakTaps>, (size_t) truePeakPhases>;
+
+        inline const TruePeakTaps& getTruePeakTaps() noexcept
+        {
+            static const TruePeakTaps taps = []
+            {
+                TruePeakTaps result {};
+                for (int phase = 0; phase < truePeakPhases; ++phase)
+                {
+                    double sum = 0.0;
+                    for (int tap = 0; tap < truePeakTaps; ++tap)
+                    {
+                        const double x = tap - (truePeakTaps / 2 - 1) - (phase + 1) / 4.0;
+                        const double sinc = std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                        const double hann = 0.5 + 0.5 * std::cos (juce::MathConstants<double>::pi * x / (truePeakTaps / 2));
+                        result[(size_t) phase][(size_t) tap] = (float) (sinc * hann);
+                        sum += sinc * hann;
+                    }
+                    for (auto& c : result[(size_t) phase]) c = (float) (c / sum);
+                }
+                return result;
+            }();
+            return taps;
+        }
+
+        inline void truePeak (const float* input, float* peaks, int start, int numSamples) noexcept
+        {
+            const auto& taps = getTruePeakTaps();
+            for (int i = start; i < numSamples; ++i)
+            {
+                const float* x = input + i;
+                float peak = std::abs (x[truePeakTaps / 2]);
+
+                for (const auto& phase : taps) {
+                    float sum = x[0] * phase[0];
+                    for (int tap = 1; tap < truePeakTaps; ++tap)
+                        sum += x[tap] * phase[(size_t) tap];
+                    peak = juce::jmax (peak, std::abs (sum));
+                }
+
+                peaks[i] = juce::jmax (peaks[i], peak);
+            }
+        }
+
+        inline float rampStep (int numSamples, float startValue, float endValue) noexcept
+        {
+            return (endValue - startValue) / (float) juce::jmax (1, numSamples);
+        }
+    }
+
+    //==============================================================================
+    namespace generic
+    {
+        inline void gainRamp (float* data, int numSamples, float startGain, float endGain) noexcept
+        {
+            detail::gainRamp (data, 0, numSamples, startGain, detail::rampStep (numSamples, startGain, endGain));
+        }
+
+        inline void mixRamp (float* wet, const float* dry, int numSamples, float startMix, float endMix) noexcept
+        {
+            detail::mixRamp (wet, dry, 0, numSamples, startMix, detail::rampStep (numSamples, startMix, endMix));
+        }
+
+        inline void width (float* left, float* right, int numSamples, float width) noexcept
+        {
+            detail::width (left, right, 0, numSamples, width);
+        }
+
+        inline void truePeak (const float* input, float* peaks, int numSamples) noexcept
+        {
+            detail::truePeak (input, peaks, 0, numSamples);
+        }
+    }
+
+   #if LOUDER_KERNELS_X86
+    //==============================================================================
+    namespace sse2
+    {
+        inline __m128 ramp (float start, float step, int i) noexcept
+        {
+            const auto index = _mm_add_ps (_mm_set1_ps ((float) i), _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f));
+            return _mm_add_ps (_mm_set1_ps (start), _mm_mul_ps (_mm_set1_ps (step), index));
+        }
+
+        inline void gainRamp (float* data, int numSamples, float startGain, float endGain) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startGain, endGain);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (data + i, _mm_mul_ps (_mm_loadu_ps (data + i), ramp (startGain, step, i)));
+            detail::gainRamp (data, i, numSamples, startGain, step);
+        }
+
+        inline void mixRamp (float* wet, const float* dry, int numSamples, float startMix, float endMix) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startMix, endMix);
+            const auto one = _mm_set1_ps (1.0f);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4) {
+                const auto mix = ramp (startMix, step, i);
+                _mm_storeu_ps (wet + i, _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (wet + i), mix),
+                                                    _mm_mul_ps (_mm_loadu_ps (dry + i), _mm_sub_ps (one, mix))));
+            }
+            detail::mixRamp (wet, dry, i, numSamples, startMix, step);
+        }
+
+        inline void width (float* left, float* right, int numSamples, float width) noexcept
+        {
+            const auto half = _mm_set1_ps (0.5f), w = _mm_set1_ps (width);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4) {
+                const auto l = _mm_loadu_ps (left + i), r = _mm_loadu_ps (right + i);
+                const auto mid = _mm_mul_ps (_mm_add_ps (l, r), half);
+                const auto side = _mm_mul_ps (_mm_mul_ps (_mm_sub_ps (l, r), half), w);
+                _mm_storeu_ps (left + i, _mm_add_ps (mid, side));
+                _mm_storeu_ps (right + i, _mm_sub_ps (mid, side));
+            }
+            detail::width (left, right, i, numSamples, width);
+        }
+
+        inline void truePeak (const float* input, float* peaks, int numSamples) noexcept
+        {
+            const auto& taps = detail::getTruePeakTaps();
+            const auto signMask = _mm_set1_ps (-0.0f);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const float* x = input + i;
+                auto peak = _mm_andnot_ps (signMask, _mm_loadu_ps (x + detail::truePeakTaps / 2));
+
+                for (const auto& phase : taps) {
+                    auto sum = _mm_mul_ps (_mm_loadu_ps (x), _mm_set1_ps (phase[0]));
+                    for (int tap = 1; tap < detail::truePeakTaps; ++tap)
+                        sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (x + tap), _mm_set1_ps (phase[(size_t) tap])));
+                    peak = _mm_max_ps (peak, _mm_andnot_ps (signMask, sum));
+                }
+
+                _mm_storeu_ps (peaks + i, _mm_max_ps (_mm_loadu_ps (peaks + i), peak));
+            }
+            detail::truePeak (input, peaks, i, numSamples);
+        }
+    }
+
+    //==============================================================================
+    namespace avx2
+    {
+        LOUDER_TARGET_AVX2 inline __m256 ramp (float start, float step, int i) noexcept
+        {
+            const auto index = _mm256_add_ps (_mm256_set1_ps ((float) i), _mm256_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+            return _mm256_add_ps (_mm256_set1_ps (start), _mm256_mul_ps (_mm256_set1_ps (step), index));
+        }
+
+        LOUDER_TARGET_AVX2 inline void gainRamp (float* data, int numSamples, float startGain, float endGain) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startGain, endGain);
+            int i = 0;
+            for (; i + 8 <= numSamples; i += 8)
+                _mm256_storeu_ps (data + i, _mm256_mul_ps (_mm256_loadu_ps (data + i), ramp (startGain, step, i)));
+            detail::gainRamp (data, i, numSamples, startGain, step);
+        }
+
+        LOUDER_TARGET_AVX2 inline void mixRamp (float* wet, const float* dry, int numSamples, float startMix, float endMix) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startMix, endMix);
+            const auto one = _mm256_set1_ps (1.0f);
+            int i = 0;
+            for (; i + 8 <= numSamples; i += 8) {
+                const auto mix = ramp (startMix, step, i);
+                _mm256_storeu_ps (wet + i, _mm256_add_ps (_mm256_mul_ps (_mm256_loadu_ps (wet + i), mix),
+                                                          _mm256_mul_ps (_mm256_loadu_ps (dry + i), _mm256_sub_ps (one, mix))));
+            }
+            detail::mixRamp (wet, dry, i, numSamples, startMix, step);
+        }
+
+        LOUDER_TARGET_AVX2 inline void width (float* left, float* right, int numSamples, float width) noexcept
+        {
+            const auto half = _mm256_set1_ps (0.5f), w = _mm256_set1_ps (width);
+            int i = 0;
+            for (; i + 8 <= numSamples; i += 8) {
+                const auto l = _mm256_loadu_ps (left + i), r = _mm256_loadu_ps (right + i);
+                const auto mid = _mm256_mul_ps (_mm256_add_ps (l, r), half);
+                const auto side = _mm256_mul_ps (_mm256_mul_ps (_mm256_sub_ps (l, r), half), w);
+                _mm256_storeu_ps (left + i, _mm256_add_ps (mid, side));
+                _mm256_storeu_ps (right + i, _mm256_sub_ps (mid, side));
+            }
+            detail::width (left, right, i, numSamples, width);
+        }
+
+        LOUDER_TARGET_AVX2 inline void truePeak (const float* input, float* peaks, int numSamples) noexcept
+        {
+            const auto& taps = detail::getTruePeakTaps();
+            const auto signMask = _mm256_set1_ps (-0.0f);
+            int i = 0;
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                const float* x = input + i;
+                auto peak = _mm256_andnot_ps (signMask, _mm256_loadu_ps (x + detail::truePeakTaps / 2));
+
+                for (const auto& phase : taps) {
+                    auto sum = _mm256_mul_ps (_mm256_loadu_ps (x), _mm256_set1_ps (phase[0]));
+                    for (int tap = 1; tap < detail::truePeakTaps; ++tap)
+                        sum = _mm256_add_ps (sum, _mm256_mul_ps (_mm256_loadu_ps (x + tap), _mm256_set1_ps (phase[(size_t) tap])));
+                    peak = _mm256_max_ps (peak, _mm256_andnot_ps (signMask, sum));
+                }
+
+                _mm256_storeu_ps (peaks + i, _mm256_max_ps (_mm256_loadu_ps (peaks + i), peak));
+            }
+            detail::truePeak (input, peaks, i, numSamples);
+        }
+
+        // Saturation::lookup, eight lanes at a time with gathers.
+        LOUDER_TARGET_AVX2 inline __m256 lookup (const float* table, __m256 x) noexcept
+        {
+            constexpr float scale = (Saturation::tableSize - 1) / (2.0f * Saturation::tableRange);
+            const auto range = _mm256_set1_ps (Saturation::tableRange);
+            const auto clamped = _mm256_min_ps (_mm256_max_ps (x, _mm256_sub_ps (_mm256_setzero_ps(), range)), range);
+            const auto pos = _mm256_mul_ps (_mm256_add_ps (clamped, range), _mm256_set1_ps (scale));
+            const auto index = _mm256_min_epi32 (_mm256_cvttps_epi32 (pos), _mm256_set1_epi32 (Saturation::tableSize - 2));
+            const auto frac = _mm256_sub_ps (pos, _mm256_cvtepi32_ps (index));
+            const auto a = _mm256_i32gather_ps (table, index, 4);
+            const auto b = _mm256_i32gather_ps (table + 1, index, 4);
+            return _mm256_add_ps (a, _mm256_mul_ps (frac, _mm256_sub_ps (b, a)));
+        }
+
+        template <Saturation::Model M>
+        LOUDER_TARGET_AVX2 void saturate (float* data, int numSamples, float gain) noexcept
+        {
+            using Saturation::Model;
+            const auto g = _mm256_set1_ps (gain);
+            const auto signMask = _mm256_set1_ps (-0.0f);
+            int i = 0;
+
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                const auto x = _mm256_mul_ps (_mm256_loadu_ps (data + i), g);
+                __m256 y;
+
+                if constexpr (M == Model::Classic)      y = lookup (Saturation::classicTable.data(), x);
+                else if constexpr (M == Model::Tube)    y = lookup (Saturation::tubeTable.data(), x);
+                else if constexpr (M == Model::Tape)    y = lookup (Saturation::tapeTable.data(), x);
+                else if constexpr (M == Model::HardClip)
+                {
+                    constexpr float knee = 0.2f;
+                    const auto mag = _mm256_andnot_ps (signMask, x);
+                    const auto over = _mm256_sub_ps (mag, _mm256_set1_ps (1.0f - knee));
+                    const auto bent = _mm256_sub_ps (mag, _mm256_div_ps (_mm256_mul_ps (over, over), _mm256_set1_ps (4.0f * knee)));
+                    y = _mm256_blendv_ps (mag, bent, _mm256_cmp_ps (mag, _mm256_set1_ps (1.0f - knee), _CMP_GT_OQ));
+                    y = _mm256_blendv_ps (y, _mm256_set1_ps (1.0f), _mm256_cmp_ps (mag, _mm256_set1_ps (1.0f + knee), _CMP_GE_OQ));
+                    y = _mm256_or_ps (y, _mm256_and_ps (x, signMask));
+                }
+                else
+                {
+                    auto t = _mm256_mul_ps (_mm256_sub_ps (x, _mm256_set1_ps (1.0f)), _mm256_set1_ps (0.25f));
+                    t = _mm256_sub_ps (t, _mm256_floor_ps (t));
+                    y = _mm256_sub_ps (_mm256_andnot_ps (signMask, _mm256_sub_ps (_mm256_mul_ps (t, _mm256_set1_ps (4.0f)), _mm256_set1_ps (2.0f))),
+                                       _mm256_set1_ps (1.0f));
+                }
+
+                _mm256_storeu_ps (data + i, y);
+            }
+
+            detail::saturate<M> (data, i, numSamples, gain);
+        }
+    }
+
+    //==============================================================================
+    namespace avx512
+    {
+        LOUDER_TARGET_AVX512 inline __m512 ramp (float start, float step, int i) noexcept
+        {
+            const auto index = _mm512_add_ps (_mm512_set1_ps ((float) i),
+                                              _mm512_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+                                                              8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f));
+            return _mm512_add_ps (_mm512_set1_ps (start), _mm512_mul_ps (_mm512_set1_ps (step), index));
+        }
+
+        LOUDER_TARGET_AVX512 inline void gainRamp (float* data, int numSamples, float startGain, float endGain) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startGain, endGain);
+            int i = 0;
+            for (; i + 16 <= numSamples; i += 16)
+                _mm512_storeu_ps (data + i, _mm512_mul_ps (_mm512_loadu_ps (data + i), ramp (startGain, step, i)));
+            detail::gainRamp (data, i, numSamples, startGain, step);
+        }
+
+        LOUDER_TARGET_AVX512 inline void mixRamp (float* wet, const float* dry, int numSamples, float startMix, float endMix) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startMix, endMix);
+            const auto one = _mm512_set1_ps (1.0f);
+            int i = 0;
+            for (; i + 16 <= numSamples; i += 16) {
+                const auto mix = ramp (startMix, step, i);
+                _mm512_storeu_ps (wet + i, _mm512_add_ps (_mm512_mul_ps (_mm512_loadu_ps (wet + i), mix),
+                                                          _mm512_mul_ps (_mm512_loadu_ps (dry + i), _mm512_sub_ps (one, mix))));
+            }
+            detail::mixRamp (wet, dry, i, numSamples, startMix, step);
+        }
+
+        LOUDER_TARGET_AVX512 inline void width (float* left, float* right, int numSamples, float width) noexcept
+        {
+            const auto half = _mm512_set1_ps (0.5f), w = _mm512_set1_ps (width);
+            int i = 0;
+            for (; i + 16 <= numSamples; i += 16) {
+                const auto l = _mm512_loadu_ps (left + i), r = _mm512_loadu_ps (right + i);
+                const auto mid = _mm512_mul_ps (_mm512_add_ps (l, r), half);
+                const auto side = _mm512_mul_ps (_mm512_mul_ps (_mm512_sub_ps (l, r), half), w);
+                _mm512_storeu_ps (left + i, _mm512_add_ps (mid, side));
+                _mm512_storeu_ps (right + i, _mm512_sub_ps (mid, side));
+            }
+            detail::width (left, right, i, numSamples, width);
+        }
+
+        LOUDER_TARGET_AVX512 inline __m512 abs (__m512 x) noexcept
+        {
+            return _mm512_castsi512_ps (_mm512_and_si512 (_mm512_castps_si512 (x), _mm512_set1_epi32 (0x7fffffff)));
+        }
+
+        LOUDER_TARGET_AVX512 inline void truePeak (const float* input, float* peaks, int numSamples) noexcept
+        {
+            const auto& taps = detail::getTruePeakTaps();
+            int i = 0;
+            for (; i + 16 <= numSamples; i += 16)
+            {
+                const float* x = input + i;
+                auto peak = abs (_mm512_loadu_ps (x + detail::truePeakTaps / 2));
+
+                for (const auto& phase : taps) {
+                    auto sum = _mm512_mul_ps (_mm512_loadu_ps (x), _mm512_set1_ps (phase[0]));
+                    for (int tap = 1; tap < detail::truePeakTaps; ++tap)
+                        sum = _mm512_add_ps (sum, _mm512_mul_ps (_mm512_loadu_ps (x + tap), _mm512_set1_ps (phase[(size_t) tap])));
+                    peak = _mm512_max_ps (peak, abs (sum));
+                }
+
+                _mm512_storeu_ps (peaks + i, _mm512_max_ps (_mm512_loadu_ps (peaks + i), peak));
+            }
+            detail::truePeak (input, peaks, i, numSamples);
+        }
+
+        LOUDER_TARGET_AVX512 inline __m512 lookup (const float* table, __m512 x) noexcept
+        {
+            constexpr float scale = (Saturation::tableSize - 1) / (2.0f * Saturation::tableRange);
+            const auto range = _mm512_set1_ps (Saturation::tableRange);
+            const auto clamped = _mm512_min_ps (_mm512_max_ps (x, _mm512_sub_ps (_mm512_setzero_ps(), range)), range);
+            const auto pos = _mm512_mul_ps (_mm512_add_ps (clamped, range), _mm512_set1_ps (scale));
+            const auto index = _mm512_min_epi32 (_mm512_cvttps_epi32 (pos), _mm512_set1_epi32 (Saturation::tableSize - 2));
+            const auto frac = _mm512_sub_ps (pos, _mm512_cvtepi32_ps (index));
+            const auto a = _mm512_i32gather_ps (index, table, 4);
+            const auto b = _mm512_i32gather_ps (index, table + 1, 4);
+            return _mm512_add_ps (a, _mm512_mul_ps (frac, _mm512_sub_ps (b, a)));
+        }
+
+        template <Saturation::Model M>
+        LOUDER_TARGET_AVX512 void saturate (float* data, int numSamples, float gain) noexcept
+        {
+            using Saturation::Model;
+            const auto g = _mm512_set1_ps (gain);
+            const auto signMask = _mm512_set1_epi32 ((int) 0x80000000u);
+            int i = 0;
+
+            for (; i + 16 <= numSamples; i += 16)
+            {
+                const auto x = _mm512_mul_ps (_mm512_loadu_ps (data + i), g);
+                __m512 y;
+
+                if constexpr (M == Model::Classic)      y = lookup (Saturation::classicTable.data(), x);
+                else if constexpr (M == Model::Tube)    y = lookup (Saturation::tubeTable.data(), x);
+                else if constexpr (M == Model::Tape)    y = lookup (Saturation::tapeTable.data(), x);
+                else if constexpr (M == Model::HardClip)
+                {
+                    constexpr float knee = 0.2f;
+                    const auto mag = abs (x);
+                    const auto over = _mm512_sub_ps (mag, _mm512_set1_ps (1.0f - knee));
+                    const auto bent = _mm512_sub_ps (mag, _mm512_div_ps (_mm512_mul_ps (over, over), _mm512_set1_ps (4.0f * knee)));
+                    y = _mm512_mask_blend_ps (_mm512_cmp_ps_mask (mag, _mm512_set1_ps (1.0f - knee), _CMP_GT_OQ), mag, bent);
+                    y = _mm512_mask_blend_ps (_mm512_cmp_ps_mask (mag, _mm512_set1_ps (1.0f + knee), _CMP_GE_OQ), y, _mm512_set1_ps (1.0f));
+                    y = _mm512_castsi512_ps (_mm512_or_si512 (_mm512_castps_si512 (y), _mm512_and_si512 (_mm512_castps_si512 (x), signMask)));
+                }
+                else
+                {
+                    auto t = _mm512_mul_ps (_mm512_sub_ps (x, _mm512_set1_ps (1.0f)), _mm512_set1_ps (0.25f));
+                    t = _mm512_sub_ps (t, _mm512_roundscale_ps (t, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+                    y = _mm512_sub_ps (abs (_mm512_sub_ps (_mm512_mul_ps (t, _mm512_set1_ps (4.0f)), _mm512_set1_ps (2.0f))),
+                                       _mm512_set1_ps (1.0f));
+                }
+
+                _mm512_storeu_ps (data + i, y);
+            }
+
+            detail::saturate<M> (data, i, numSamples, gain);
+        }
+    }
+   #endif
+
+   #if LOUDER_KERNELS_NEON
+    //==============================================================================
+    namespace neon
+    {
+        inline float32x4_t ramp (float start, float step, int i) noexcept
+        {
+            const float offsets[] = { 0.0f, 1.0f, 2.0f, 3.0f };
+            const auto index = vaddq_f32 (vdupq_n_f32 ((float) i), vld1q_f32 (offsets));
+            return vaddq_f32 (vdupq_n_f32 (start), vmulq_f32 (vdupq_n_f32 (step), index));
+        }
+
+        inline void gainRamp (float* data, int numSamples, float startGain, float endGain) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startGain, endGain);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4)
+                vst1q_f32 (data + i, vmulq_f32 (vld1q_f32 (data + i), ramp (startGain, step, i)));
+            detail::gainRamp (data, i, numSamples, startGain, step);
+        }
+
+        inline void mixRamp (float* wet, const float* dry, int numSamples, float startMix, float endMix) noexcept
+        {
+            const float step = detail::rampStep (numSamples, startMix, endMix);
+            const auto one = vdupq_n_f32 (1.0f);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4) {
+                const auto mix = ramp (startMix, step, i);
+                vst1q_f32 (wet + i, vaddq_f32 (vmulq_f32 (vld1q_f32 (wet + i), mix),
+                                               vmulq_f32 (vld1q_f32 (dry + i), vsubq_f32 (one, mix))));
+            }
+            detail::mixRamp (wet, dry, i, numSamples, startMix, step);
+        }
+
+        inline void width (float* left, float* right, int numSamples, float width) noexcept
+        {
+            const auto half = vdupq_n_f32 (0.5f), w = vdupq_n_f32 (width);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4) {
+                const auto l = vld1q_f32 (left + i), r = vld1q_f32 (right + i);
+                const auto mid = vmulq_f32 (vaddq_f32 (l, r), half);
+                const auto side = vmulq_f32 (vmulq_f32 (vsubq_f32 (l, r), half), w);
+                vst1q_f32 (left + i, vaddq_f32 (mid, side));
+                vst1q_f32 (right + i, vsubq_f32 (mid, side));
+            }
+            detail::width (left, right, i, numSamples, width);
+        }
+
+        inline void truePeak (const float* input, float* peaks, int numSamples) noexcept
+        {
+            const auto& taps = detail::getTruePeakTaps();
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const float* x = input + i;
+                auto peak = vabsq_f32 (vld1q_f32 (x + detail::truePeakTaps / 2));
+
+                for (const auto& phase : taps) {
+                    auto sum = vmulq_f32 (vld1q_f32 (x), vdupq_n_f32 (phase[0]));
+                    for (int tap = 1; tap < detail::truePeakTaps; ++tap)
+                        sum = vaddq_f32 (sum, vmulq_f32 (vld1q_f32 (x + tap), vdupq_n_f32 (phase[(size_t) tap])));
+                    peak = vmaxq_f32 (peak, vabsq_f32 (sum));
+                }
+
+                vst1q_f32 (peaks + i, vmaxq_f32 (vld1q_f32 (peaks + i), peak));
+            }
+            detail::truePeak (input, peaks, i, numSamples);
+        }
+    }
+   #endif
+
+    //==============================================================================
+    // Without gathers (SSE2, NEON) a table lookup is scalar anyway, so those tables keep the
+    // generic curves; AVX2 and AVX-512 have their own.
+    inline const Table& getTable (Isa isa) noexcept
+    {
+        using Saturation::Model;
+        const auto genericCurves = Saturation::dispatchTable[(size_t) Saturation::Quality::Table];
+
+        static const Table genericTable { Isa::generic, &generic::gainRamp, &generic::mixRamp, &generic::width, &generic::truePeak, genericCurves };
+
+       #if LOUDER_KERNELS_X86
+        static const Table sse2Table { Isa::sse2, &sse2::gainRamp, &sse2::mixRamp, &sse2::width, &sse2::truePeak, genericCurves };
+
+        static const Table avx2Table { Isa::avx2, &avx2::gainRamp, &avx2::mixRamp, &avx2::width, &avx2::truePeak,
+                                       { &avx2::saturate<Model::Classic>, &avx2::saturate<Model::Tube>, &avx2::saturate<Model::Tape>,
+                                         &avx2::saturate<Model::HardClip>, &avx2::saturate<Model::Foldback> } };
+
+        static const Table avx512Table { Isa::avx512, &avx512::gainRamp, &avx512::mixRamp, &avx512::width, &avx512::truePeak,
+                                         { &avx512::saturate<Model::Classic>, &avx512::saturate<Model::Tube>, &avx512::saturate<Model::Tape>,
+                                           &avx512::saturate<Model::HardClip>, &avx512::saturate<Model::Foldback> } };
+
+        if (isa == Isa::sse2)   return sse2Table;
+        if (isa == Isa::avx2)   return avx2Table;
+        if (isa == Isa::avx512) return avx512Table;
+       #elif LOUDER_KERNELS_NEON
+        static const Table neonTable { Isa::neon, &neon::gainRamp, &neon::mixRamp, &neon::width, &neon::truePeak, genericCurves };
+
+        if (isa == Isa::neon)   return neonTable;
+       #endif
+
+        return genericTable;
+    }
+
+    // The widest supported variant. Setting the LOUDER_KERNELS environment variable to an ISA name
+    // caps it there, e.g. to keep a machine that downclocks under AVX-512 on AVX2.
+    inline Isa getBestIsa() noexcept
+    {
+        static const Isa best = []
+        {
+            const auto cap = juce::SystemStats::getEnvironmentVariable ("LOUDER_KERNELS", {}).trim().toLowerCase();
+            auto result = Isa::generic;
+
+            for (int i = 0; i < (int) Isa::numIsas; ++i)
+            {
+                const auto isa = (Isa) i;
+                if (isSupported (isa)) result = isa;
+                if (cap == getIsaName (isa)) break;
+            }
+
+            return result;
+        }();
+
+        return best;
+    }
+
+    // Exact curves call std::tanh per sample and only run offline, so they stay scalar.
+    inline Saturation::BlockFunction getSaturation (const Table& table, int modelIndex, Saturation::Quality quality) noexcept
+    {
+        if (quality != Saturation::Quality::Table)
+            return Saturation::getBlockFunction (modelIndex, quality);
+
+        return table.saturate[(size_t) juce::jlimit (0, (int) Saturation::Model::numModels - 1, modelIndex)];
+    }
+}
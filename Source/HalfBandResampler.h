@@ -0,0 +1,219 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Streaming decimator/interpolator built from cascaded 2x half-band stages: mono down, stereo up,
+// which is the shape of a reverb's wet path. Each stage is a polyphase IIR: two chains of
+// first-order allpasses running at the low rate, one of them fed the odd samples. Works on any
+// block size; a stage that is halfway through a sample pair just carries it over to the next block.
+//
+// down() and up() must be called with the same numSamples every block: up() replays the phase
+// pattern down() went through, so it consumes exactly the low-rate samples down() produced.
+class HalfBandResampler
+{
+public:
+    static constexpr int maxStages = 2;
+    static constexpr int maxCoefficients = 6;
+
+    // 0 stages = pass-through, 1 = 2x, 2 = 4x.
+    void setNumStages (int newNumStages) noexcept
+    {
+        numStages = juce::jlimit (0, maxStages, newNumStages);
+        reset();
+
+        // Only the innermost stage guards the audible band's edge. In a 4x cascade the outer stage
+        // just has to keep 0.396..0.5 fs from folding below 20 kHz, which a much cheaper filter does.
+        for (int s = 0; s < numStages; ++s)
+            stages[s].design = (s == numStages - 1) ? &getDesign (Design::narrow) : &getDesign (Design::wide);
+    }
+
+    int getNumStages() const noexcept { return numStages; }
+    int getFactor() const noexcept    { return 1 << numStages; }
+
+    void reset() noexcept
+    {
+        for (auto& s : stages) {
+            s.down = {};
+            s.up[0] = s.up[1] = {};
+            s.held = s.pending[0] = s.pending[1] = 0.0f;
+            s.downPhase = s.upPhase = 0;
+        }
+    }
+
+    // Largest number of low-rate samples down() can produce from numSamples of input.
+    int getMaxDecimatedSamples (int numSamples) const noexcept { return numSamples / getFactor() + 1; }
+
+    // Returns the number of low-rate samples written to 'output', which may be the same buffer as
+    // 'input' (it never gets ahead of the read position).
+    int down (const float* input, float* output, int numSamples) noexcept
+    {
+        int produced = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float x = input[i];
+            bool ready = true;
+
+            for (int s = 0; s < numStages && ready; ++s)
+            {
+                auto& stage = stages[s];
+                if (stage.downPhase == 0) {
+                    stage.held = x;
+                    ready = false;
+                } else {
+                    x = decimate (*stage.design, stage.down, stage.held, x);
+                }
+                stage.downPhase ^= 1;
+            }
+
+            if (ready) output[produced++] = x;
+        }
+
+        return produced;
+    }
+
+    // Interpolates the low-rate block from the matching down() call back to the full rate and adds
+    // it to outL/outR.
+    void upAdd (const float* inL, const float* inR, float* outL, float* outR, int numSamples) noexcept
+    {
+        int consumed = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Find how far in this sample reaches: the first stage sitting on the first half of a
+            // pair answers from what it buffered last time; otherwise we go one stage deeper.
+            int depth = 0;
+            while (depth < numStages && stages[depth].upPhase == 1)
+                ++depth;
+
+            float l, r;
+            if (depth == numStages) {
+                l = inL[consumed];
+                r = inR[consumed];
+                ++consumed;
+            } else {
+                l = stages[depth].pending[0];
+                r = stages[depth].pending[1];
+                stages[depth].upPhase = 1;
+            }
+
+            for (int s = depth - 1; s >= 0; --s)
+            {
+                auto& stage = stages[s];
+                l = interpolate (*stage.design, stage.up[0], l, stage.pending[0]);
+                r = interpolate (*stage.design, stage.up[1], r, stage.pending[1]);
+                stage.upPhase = 0;
+            }
+
+            outL[i] += l;
+            outR[i] += r;
+        }
+    }
+
+private:
+    struct Coefficients
+    {
+        std::array<float, maxCoefficients> c {};
+        int size = 0;
+    };
+
+    // narrow: 6 coefficients, 0.08 transition. Flat to 0.208 fs, > 0.292 fs down 95 dB, so 20 kHz
+    //         passes untouched at 96 kHz and nothing folds back into the audible band.
+    // wide:   4 coefficients, 0.29 transition. Flat to 0.104 fs, > 0.396 fs down 130 dB.
+    enum class Design { narrow, wide };
+
+    // Rate-independent, so each design is worked out once per process and shared by every instance.
+    static const Coefficients& getDesign (Design design)
+    {
+        static const Coefficients narrow = computeCoefficients (6, 0.08);
+        static const Coefficients wide   = computeCoefficients (4, 0.29);
+        return design == Design::narrow ? narrow : wide;
+    }
+
+    // Elliptic half-band polyphase design after de Soras' HIIR: coefficients from the coefficient
+    // count and the transition width (as a fraction of the input rate).
+    static Coefficients computeCoefficients (int numCoefficients, double transition)
+    {
+        Coefficients result;
+        result.size = juce::jlimit (2, maxCoefficients, numCoefficients & ~1);
+        auto& c = result.c;
+        const double pi = juce::MathConstants<double>::pi;
+
+        double k = std::tan ((1.0 - transition * 2.0) * pi / 4.0);
+        k *= k;
+        const double kksqrt = std::pow (1.0 - k * k, 0.25);
+        const double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+        const double e4 = e * e * e * e;
+        const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+        const int order = result.size * 2 + 1;
+
+        for (int i = 0; i < result.size; ++i)
+        {
+            double num = 0.0, den = 0.0, term = 0.0;
+            int sign = 1;
+            for (int n = 0; n == 0 || std::abs (term) > 1.0e-100; ++n, sign = -sign) {
+                term = std::pow (q, n * (n + 1)) * std::sin ((n * 2 + 1) * (i + 1) * pi / order) * sign;
+                num += term;
+            }
+            sign = -1;
+            for (int n = 1; n == 1 || std::abs (term) > 1.0e-100; ++n, sign = -sign) {
+                term = std::pow (q, n * n) * std::cos (n * 2 * (i + 1) * pi / order) * sign;
+                den += term;
+            }
+
+            const double ww = num * std::pow (q, 0.25) / (den + 0.5);
+            const double wwsq = ww * ww;
+            const double x = std::sqrt ((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+            c[(size_t) i] = (float) ((1.0 - x) / (1.0 + x));
+        }
+
+        return result;
+    }
+
+    struct Allpasses
+    {
+        float x[maxCoefficients] {}, y[maxCoefficients] {};
+    };
+
+    struct Stage
+    {
+        const Coefficients* design = nullptr;
+        Allpasses down, up[2];
+        float held = 0.0f, pending[2] {};
+        int downPhase = 0, upPhase = 0;
+    };
+
+    // Even coefficients filter path 0, odd ones path 1; each section is y = c (x - y[-1]) + x[-1].
+    static void runPaths (const Coefficients& coefficients, Allpasses& ap, float& path0, float& path1) noexcept
+    {
+        const auto& c = coefficients.c;
+        for (int i = 0; i < coefficients.size; i += 2)
+        {
+            const float x0 = ap.x[i], x1 = ap.x[i + 1];
+            ap.x[i] = path0;
+            ap.x[i + 1] = path1;
+            path0 = (path0 - ap.y[i]) * c[(size_t) i] + x0;
+            path1 = (path1 - ap.y[i + 1]) * c[(size_t) i + 1] + x1;
+            ap.y[i] = path0;
+            ap.y[i + 1] = path1;
+        }
+    }
+
+    static float decimate (const Coefficients& coefficients, Allpasses& ap, float first, float second) noexcept
+    {
+        float path0 = second, path1 = first;
+        runPaths (coefficients, ap, path0, path1);
+        return 0.5f * (path0 + path1);
+    }
+
+    // Returns the first output of the pair and leaves the second in 'next'.
+    static float interpolate (const Coefficients& coefficients, Allpasses& ap, float input, float& next) noexcept
+    {
+        float path0 = input, path1 = input;
+        runPaths (coefficients, ap, path0, path1);
+        next = path1;
+        return path0;
+    }
+
+    Stage stages[maxStages];
+    int numStages = 0;
+};
@@ -0,0 +1,204 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+// Brickwall peak limiter for the end of the chain. Every sample's required gain comes from the
+// largest peak in the next 'lookahead' samples, found with a monotonic deque, so each sample costs
+// O(1) amortized whatever the window length. That gain gets an instant attack, a one-pole release
+// and a moving average over the window. The signal is delayed by the window length, which puts the
+// averaged ramp fully ahead of the peak it's for, so the output never overshoots the ceiling.
+//
+// The detector also looks between samples: three interpolated points per sample (Kernels::truePeak,
+// 4x oversampling with an 8-tap windowed sinc) catch most of the inter-sample overs a codec or DAC
+// would reconstruct. A final clip at the ceiling mops up float rounding; it never touches real overs.
+//
+// Peaks are linked across channels so the stereo image doesn't shift under reduction. Any block size
+// works; blocks longer than the prepared size are processed in pieces.
+class LookaheadLimiter
+{
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr double lookaheadSeconds = 0.0015;
+    static constexpr double releaseSeconds = 0.06;
+
+    // Allocates; not on the audio thread.
+    void prepare (double sampleRate, int maxBlockSize, const Kernels::Table& kernels)
+    {
+        truePeak = kernels.truePeak;
+        blockSize = juce::jmax (1, maxBlockSize);
+        window = juce::jmax (2, (int) std::ceil (lookaheadSeconds * sampleRate)) + 1;
+        releaseCoefficient = (float) (1.0 - std::exp (-1.0 / (releaseSeconds * sampleRate)));
+
+        int capacity = 1;
+        while (capacity < window + 1) capacity <<= 1;
+        dequeMask = capacity - 1;
+        dequePeaks.assign ((size_t) capacity, 0.0f);
+        dequeTimes.assign ((size_t) capacity, 0);
+        smoothing.assign ((size_t) window, 1.0f);
+
+        for (int ch = 0; ch < maxChannels; ++ch) {
+            history[ch].assign ((size_t) (blockSize + numTaps - 1), 0.0f);
+            delay[ch].assign ((size_t) getLatencyInSamples(), 0.0f);
+        }
+        peaks.assign ((size_t) blockSize, 0.0f);
+        gains.assign ((size_t) blockSize, 1.0f);
+        scratch.assign ((size_t) juce::jmax (blockSize, getLatencyInSamples()), 0.0f);
+
+        reset();
+    }
+
+    // Audio thread safe. Silence in, no reduction.
+    void reset() noexcept
+    {
+        for (int ch = 0; ch < maxChannels; ++ch) {
+            std::fill (history[ch].begin(), history[ch].end(), 0.0f);
+            std::fill (delay[ch].begin(), delay[ch].end(), 0.0f);
+        }
+        std::fill (smoothing.begin(), smoothing.end(), 1.0f);
+        smoothingSum = (double) window;
+        smoothingIndex = 0;
+        release = 1.0f;
+        dequeHead = dequeSize = 0;
+        time = 0;
+        minGain = 1.0f;
+    }
+
+    // Linear gain, e.g. 0.891 for -1 dBFS. Changes apply from the next sample through the same
+    // smoothing as the gain, with the final clip holding the new ceiling meanwhile.
+    void setCeiling (float newCeiling) noexcept  { ceiling = juce::jmax (1.0e-3f, newCeiling); }
+
+    // The window plus the interpolator's centre tap. Fixed from prepare() on.
+    int getLatencyInSamples() const noexcept     { return window - 1 + detectorDelay; }
+
+    // Smallest gain applied during the last process() call, for metering.
+    float getMinGain() const noexcept            { return minGain; }
+
+    size_t getHeapBytes() const noexcept
+    {
+        size_t floats = smoothing.size() + dequePeaks.size() + peaks.size() + gains.size() + scratch.size();
+        for (int ch = 0; ch < maxChannels; ++ch) floats += history[ch].size() + delay[ch].size();
+        return floats * sizeof (float) + dequeTimes.size() * sizeof (juce::uint32);
+    }
+
+    void process (float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        numChannels = juce::jmin (numChannels, maxChannels);
+        minGain = 1.0f;
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            const int n = juce::jmin (blockSize, numSamples - start);
+            detectPeaks (channels, numChannels, start, n);
+            computeGains (n);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* data = channels[ch] + start;
+                delayInPlace (delay[ch].data(), data, n);
+                juce::FloatVectorOperations::multiply (data, gains.data(), n);
+                juce::FloatVectorOperations::clip (data, data, -ceiling, ceiling, n);
+            }
+        }
+    }
+
+private:
+    static constexpr int numTaps = Kernels::detail::truePeakTaps;
+    static constexpr int detectorDelay = numTaps / 2 - 1;
+
+    // peaks[i] = linked peak of the sample 'detectorDelay' before i and the points leading up to it.
+    void detectPeaks (float* const* channels, int numChannels, int start, int n) noexcept
+    {
+        juce::FloatVectorOperations::clear (peaks.data(), n);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* h = history[ch].data();
+            juce::FloatVectorOperations::copy (h + numTaps - 1, channels[ch] + start, n);
+            truePeak (h, peaks.data(), n);
+            std::memmove (h, h + n, sizeof (float) * (size_t) (numTaps - 1));
+        }
+    }
+
+    // The serial part: sliding maximum, release, then the moving average that forms the attack.
+    // State lives in locals for the loop: the float stores to the buffers could otherwise alias it.
+    void computeGains (int n) noexcept
+    {
+        auto* peakValues = dequePeaks.data();
+        auto* peakTimes = dequeTimes.data();
+        auto* averageHistory = smoothing.data();
+        int head = dequeHead, size = dequeSize, index = smoothingIndex;
+        auto now = time;
+        double sum = smoothingSum;
+        float gainNow = release, lowest = minGain;
+        const double scale = 1.0 / window;
+
+        for (int i = 0; i < n; ++i)
+        {
+            const float peak = peaks[(size_t) i];
+            while (size > 0 && peakValues[(head + size - 1) & dequeMask] <= peak)
+                --size;
+
+            const int back = (head + size++) & dequeMask;
+            peakValues[back] = peak;
+            peakTimes[back] = now;
+
+            if (now - peakTimes[head] >= (juce::uint32) window) {
+                head = (head + 1) & dequeMask;
+                --size;
+            }
+            ++now;
+
+            const float maxPeak = peakValues[head];
+            const float target = maxPeak > ceiling ? ceiling / maxPeak : 1.0f;
+            gainNow = target < gainNow ? target : gainNow + (target - gainNow) * releaseCoefficient;
+
+            sum += (double) gainNow - (double) averageHistory[index];
+            averageHistory[index] = gainNow;
+            if (++index == window) index = 0;
+
+            const float gain = juce::jmin (1.0f, (float) (sum * scale));
+            gains[(size_t) i] = gain;
+            lowest = juce::jmin (lowest, gain);
+        }
+
+        dequeHead = head;
+        dequeSize = size;
+        smoothingIndex = index;
+        time = now;
+        smoothingSum = sum;
+        release = gainNow;
+        minGain = lowest;
+    }
+
+    // Shifts 'data' later by the latency, with the saved tail of the previous block going in front.
+    void delayInPlace (float* line, float* data, int n) noexcept
+    {
+        const int length = getLatencyInSamples();
+        auto* temp = scratch.data();
+
+        if (n >= length)
+        {
+            juce::FloatVectorOperations::copy (temp, data + n - length, length);
+            std::memmove (data + length, data, sizeof (float) * (size_t) (n - length));
+            juce::FloatVectorOperations::copy (data, line, length);
+            juce::FloatVectorOperations::copy (line, temp, length);
+        }
+        else
+        {
+            juce::FloatVectorOperations::copy (temp, line, n);
+            std::memmove (line, line + n, sizeof (float) * (size_t) (length - n));
+            juce::FloatVectorOperations::copy (line + length - n, data, n);
+            juce::FloatVectorOperations::copy (data, temp, n);
+        }
+    }
+
+    std::vector<float> history[maxChannels], delay[maxChannels];
+    std::vector<float> peaks, gains, scratch, smoothing, dequePeaks;
+    std::vector<juce::uint32> dequeTimes;
+    Kernels::PeakFunction truePeak = &Kernels::generic::truePeak;
+    double smoothingSum = 0.0;
+    int blockSize = 1, window = 2, smoothingIndex = 0;
+    int dequeMask = 0, dequeHead = 0, dequeSize = 0;
+    juce::uint32 time = 0;
+    float ceiling = 1.0f, release = 1.0f, releaseCoefficient = 0.001f, minGain = 1.0f;
+};
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SaturationCurves.h"
 
 NewLouderSaturator_Feb21AudioProcessorEditor::NewLouderSaturator_Feb21AudioProcessorEditor (NewLouderSaturator_Feb21AudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
@@ -59,6 +60,81 @@ NewLouderSaturator_Feb21AudioProcessorEditor::NewLouderSaturator_Feb21AudioProce
     reverbTypeCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
     addAndMakeVisible(reverbTypeCombo);
 
+    satModelCombo.addItemList(Saturation::modelNames, 1);
+    satModelCombo.setJustificationType(juce::Justification::centred);
+    satModelCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    satModelCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(satModelCombo);
+
+    chainLabel.setText("CHAIN", juce::dontSendNotification);
+    chainLabel.setFont(juce::FontOptions(11.0f).withStyle("Bold"));
+    chainLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+    chainLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(chainLabel);
+
+    for (int slot = 0; slot < (int) std::size (chainButtons); ++slot)
+    {
+        auto& b = chainButtons[slot];
+        b.setColour (juce::TextButton::buttonColourId, juce::Colour (0xFF2D2D2D));
+        b.setColour (juce::TextButton::textColourOffId, juce::Colour (0xFFE0E0E0));
+        b.onClick = [this, slot] {
+            auto order = audioProcessor.getModuleOrder();
+            std::swap (order[(size_t) slot], order[(size_t) (slot + 1) % order.size()]);
+            audioProcessor.setModuleOrder (order);
+            refreshChainButtons();
+        };
+        addAndMakeVisible (b);
+    }
+    refreshChainButtons();
+    offlineQualityCombo.addItem("Render: Realtime", 1);
+    offlineQualityCombo.addItem("Render: High", 2);
+    offlineQualityCombo.addItem("Render: Ultra", 3);
+    offlineQualityCombo.setJustificationType(juce::Justification::centred);
+    offlineQualityCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    offlineQualityCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(offlineQualityCombo);
+
+    bypassTailCombo.addItem("Tail: Ring Out", 1);
+    bypassTailCombo.addItem("Tail: Flush", 2);
+    bypassTailCombo.setJustificationType(juce::Justification::centred);
+    bypassTailCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    bypassTailCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(bypassTailCombo);
+
+    reverbDecimateCombo.addItem("Rev: Full Rate", 1);
+    reverbDecimateCombo.addItem("Rev: Decimated", 2);
+    reverbDecimateCombo.setJustificationType(juce::Justification::centred);
+    reverbDecimateCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    reverbDecimateCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(reverbDecimateCombo);
+
+    reverbStorageCombo.addItem("Rev Mem: 32-bit", 1);
+    reverbStorageCombo.addItem("Rev Mem: 16-bit", 2);
+    reverbStorageCombo.setJustificationType(juce::Justification::centred);
+    reverbStorageCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    reverbStorageCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(reverbStorageCombo);
+
+    governorCombo.addItem("CPU Gov: Off", 1);
+    governorCombo.addItem("CPU Gov: On", 2);
+    governorCombo.setJustificationType(juce::Justification::centred);
+    governorCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    governorCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(governorCombo);
+
+    limiterCombo.addItem("Limiter: Off", 1);
+    limiterCombo.addItem("Limiter: On", 2);
+    limiterCombo.setJustificationType(juce::Justification::centred);
+    limiterCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF2D2D2D));
+    limiterCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xFF3A3A3A));
+    addAndMakeVisible(limiterCombo);
+
+    ceilingSlider.setSliderStyle (juce::Slider::LinearBar);
+    ceilingSlider.setColour (juce::Slider::backgroundColourId, juce::Colour (0xFF2D2D2D));
+    ceilingSlider.setColour (juce::Slider::trackColourId, utilColor);
+    ceilingSlider.setColour (juce::Slider::textBoxOutlineColourId, juce::Colour (0xFF3A3A3A));
+    addAndMakeVisible (ceilingSlider);
+
     inputAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "input", inputSlider);
     driveAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "drive", driveSlider);
     reverbAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "reverb", reverbSlider);
@@ -68,14 +144,60 @@ NewLouderSaturator_Feb21AudioProcessorEditor::NewLouderSaturator_Feb21AudioProce
     widthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "width", widthSlider);
     mixAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "mix", mixSlider);
     outputAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "output", outputSlider);
+    ceilingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "ceiling", ceilingSlider);
     
     // ---> THE FIX: Hooking the ButtonAttachment up to the newly renamed ID <---
     prePostAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (audioProcessor.apvts, "prePostSwitch", prePostButton);
     
     typeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "reverbType", reverbTypeCombo);
+    satModelAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "satModel", satModelCombo);
+    offlineQualityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "offlineQuality", offlineQualityCombo);
     bypassAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (audioProcessor.apvts, "bypass", bypassButton);
+    bypassTailAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "bypassTail", bypassTailCombo);
+    reverbDecimateAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "reverbDecimate", reverbDecimateCombo);
+    reverbStorageAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "reverbStorage", reverbStorageCombo);
+    governorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "governor", governorCombo);
+    limiterAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (audioProcessor.apvts, "limiter", limiterCombo);
+
+   #if LOUDER_ENABLE_PROFILER
+    for (auto* b : { &profilerButton, &traceButton }) {
+        b->setClickingTogglesState (true);
+        b->setColour (juce::TextButton::buttonColourId, juce::Colour (0xFF2D2D2D));
+        b->setColour (juce::TextButton::buttonOnColourId, juce::Colour (0xFF0087FF));
+        addAndMakeVisible (*b);
+    }
+
+    profilerButton.onClick = [this] {
+        if (profilerButton.getToggleState()) audioProcessor.profiler.requestReset();
+        profilerOverlay.setVisible (profilerButton.getToggleState());
+    };
+
+    traceButton.onClick = [this] {
+        if (traceButton.getToggleState()) {
+            auto file = juce::File::getSpecialLocation (juce::File::userDesktopDirectory)
+                          .getNonexistentChildFile ("LOUDER_trace_" + juce::Time::getCurrentTime().formatted ("%Y%m%d_%H%M%S"), ".json");
+            traceWriter = std::make_unique<StageProfiler::TraceWriter> (audioProcessor.profiler, file);
+        } else {
+            traceWriter.reset();
+        }
+    };
+
+    addChildComponent (profilerOverlay);
+   #endif
+
+    if (audioProcessor.wrapperType == juce::AudioProcessor::wrapperType_Standalone)
+    {
+        diagnostics = std::make_unique<StandaloneDiagnostics> (audioProcessor.callbackMonitor);
+        addChildComponent (*diagnostics);
+
+        diagnosticsButton.setClickingTogglesState (true);
+        diagnosticsButton.setColour (juce::TextButton::buttonColourId, juce::Colour (0xFF2D2D2D));
+        diagnosticsButton.setColour (juce::TextButton::buttonOnColourId, juce::Colour (0xFF0087FF));
+        diagnosticsButton.onClick = [this] { diagnostics->setVisible (diagnosticsButton.getToggleState()); };
+        addAndMakeVisible (diagnosticsButton);
+    }
 
-    setSize (640, 520); 
+    setSize (640, 550); 
     startTimerHz(30);
 }
 
@@ -89,9 +211,23 @@ void NewLouderSaturator_Feb21AudioProcessorEditor::timerCallback()
 {
     smoothInputLevel = juce::jmax(audioProcessor.inputLevel.load(), smoothInputLevel * 0.85f);
     smoothOutputLevel = juce::jmax(audioProcessor.outputLevel.load(), smoothOutputLevel * 0.85f);
+    smoothReductionDb = juce::jmax(-juce::Decibels::gainToDecibels(audioProcessor.limiterGain.load()), smoothReductionDb * 0.85f);
+    refreshChainButtons();
     repaint();
 }
 
+// Also picks up PRE/POST changes and recalled state, since the order is derived from both.
+void NewLouderSaturator_Feb21AudioProcessorEditor::refreshChainButtons()
+{
+    const auto order = audioProcessor.getModuleOrder();
+    for (size_t slot = 0; slot < order.size(); ++slot)
+    {
+        auto text = juce::String (NewLouderSaturator_Feb21AudioProcessor::getModuleName (order[slot])).toUpperCase();
+        if (slot + 1 < order.size()) text << "  >";
+        if (chainButtons[slot].getButtonText() != text) chainButtons[slot].setButtonText (text);
+    }
+}
+
 void NewLouderSaturator_Feb21AudioProcessorEditor::paint (juce::Graphics& g)
 {
     g.fillAll (juce::Colour (0xFF1A1A1A)); 
@@ -109,6 +245,15 @@ void NewLouderSaturator_Feb21AudioProcessorEditor::paint (juce::Graphics& g)
     g.drawText("IN", 15, meterY - 20, 20, 20, juce::Justification::centred);
     g.drawText("OUT", getWidth() - 35, meterY - 20, 20, 20, juce::Justification::centred);
 
+    // Governor readout: the tier the chain is running at and the p95 share of the block deadline.
+    if (audioProcessor.apvts.getRawParameterValue("governor")->load() > 0.5f) {
+        const int tier = audioProcessor.governorTier.load();
+        const int loadPercent = juce::roundToInt (audioProcessor.governorLoad.load() * 100.0f);
+        g.setColour (tier > 0 ? juce::Colour (0xFFE53935) : juce::Colours::grey);
+        g.drawText ((tier > 0 ? "CPU: TIER " + juce::String (tier) : juce::String ("CPU: FULL")) + "  P95 " + juce::String (loadPercent) + "%",
+                    320, 15, 150, 20, juce::Justification::centredLeft);
+    }
+
     g.setColour (juce::Colour (0xFF2D2D2D));
     g.fillRect (20, meterY, meterWidth, meterHeight);
     g.setColour (juce::Colour (0xFF0087FF));
@@ -120,6 +265,12 @@ void NewLouderSaturator_Feb21AudioProcessorEditor::paint (juce::Graphics& g)
     g.setColour (juce::Colour (0xFF0087FF));
     float outFill = meterHeight * juce::jmin (1.0f, smoothOutputLevel);
     g.fillRect ((float)(getWidth() - 30), meterY + meterHeight - outFill, (float)meterWidth, outFill);
+
+    // Limiter gain reduction hangs from the top of the output meter, full height at 24 dB.
+    if (smoothReductionDb > 0.05f) {
+        g.setColour (juce::Colour (0xFFE53935));
+        g.fillRect ((float)(getWidth() - 30), (float)meterY, (float)meterWidth, meterHeight * juce::jmin (1.0f, smoothReductionDb / 24.0f));
+    }
 }
 
 void NewLouderSaturator_Feb21AudioProcessorEditor::resized()
@@ -130,17 +281,45 @@ void NewLouderSaturator_Feb21AudioProcessorEditor::resized()
     };
 
     bypassButton.setBounds (15, 15, 60, 20); 
+    bypassTailCombo.setBounds (80, 15, 110, 20);
+    reverbDecimateCombo.setBounds (80, 40, 110, 20);
+    reverbStorageCombo.setBounds (195, 40, 120, 20);
+    governorCombo.setBounds (195, 15, 120, 20);
+    limiterCombo.setBounds (320, 40, 100, 20);
+    ceilingSlider.setBounds (425, 40, 75, 20);
+    offlineQualityCombo.setBounds (getWidth() - 135, 15, 120, 20);
+
+   #if LOUDER_ENABLE_PROFILER
+    traceButton.setBounds (getWidth() - 135, 40, 38, 20);
+    profilerButton.setBounds (getWidth() - 94, 40, 38, 20);
+    profilerOverlay.setBounds (getLocalBounds().reduced (55, 60));
+    diagnosticsButton.setBounds (getWidth() - 53, 40, 38, 20);
+   #else
+    diagnosticsButton.setBounds (getWidth() - 135, 40, 58, 20);
+   #endif
+
+    if (diagnostics != nullptr)
+        diagnostics->setBounds (getLocalBounds().reduced (55, 60));
 
     auto area = getLocalBounds().reduced (55, 0); 
     area.removeFromTop (60); 
     auto bottomRow = area.removeFromBottom (100); 
 
+    auto chainRow = area.removeFromBottom (30).reduced (10, 4);
+    chainLabel.setBounds (chainRow.removeFromLeft (50));
+    const int chainSlotW = chainRow.getWidth() / (int) std::size (chainButtons);
+    for (auto& b : chainButtons)
+        b.setBounds (chainRow.removeFromLeft (chainSlotW).reduced (3, 0));
+
     auto satArea = area.removeFromLeft (area.getWidth() / 2.0f).reduced(10);
     auto revArea = area.reduced(10);
 
     satSectionLabel.setBounds(satArea.removeFromTop(30));
     revSectionLabel.setBounds(revArea.removeFromTop(30));
 
+    satModelCombo.setBounds(satArea.removeFromTop(20).withSizeKeepingCentre(90, 20));
+    satArea.removeFromTop(12); 
+
     bindKnob (driveSlider, driveLabel, satArea.removeFromTop (160).withSizeKeepingCentre (140, 160));
     bindKnob (toneSlider, toneLabel, satArea.removeFromTop (100).withSizeKeepingCentre (90, 110));   
 
@@ -1,6 +1,7 @@
 #pragma once
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "StandaloneDiagnostics.h"
 
 class CustomLookAndFeel : public juce::LookAndFeel_V4
 {
@@ -94,6 +95,60 @@ public:
     }
 };
 
+#if LOUDER_ENABLE_PROFILER
+class ProfilerOverlay : public juce::Component
+{
+public:
+    explicit ProfilerOverlay (StageProfiler& p) : profiler (p)
+    {
+        setInterceptsMouseClicks (false, false);
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat();
+        g.setColour (juce::Colour (0xE01A1A1A));
+        g.fillRoundedRectangle (bounds, 4.0f);
+        g.setColour (juce::Colour (0xFF3A3A3A));
+        g.drawRoundedRectangle (bounds.reduced (1.0f), 4.0f, 2.0f);
+
+        auto area = getLocalBounds().reduced (12);
+        g.setFont (juce::FontOptions (11.0f).withStyle ("Bold"));
+        g.setColour (juce::Colour (0xFF0087FF));
+        g.drawText ("STAGE CYCLES / BLOCK        MEAN      P50      P99      MAX", area.removeFromTop (20), juce::Justification::centredLeft);
+
+        // Bars are log2-scaled against the worst p99 so cheap stages stay visible next to the reverb.
+        StageProfiler::StageStats stats[StageProfiler::numStages];
+        double worst = 1.0;
+        for (int s = 0; s < StageProfiler::numStages; ++s) {
+            stats[s] = profiler.getStats (s);
+            worst = juce::jmax (worst, std::log2 ((double) stats[s].p99Cycles + 1.0));
+        }
+
+        g.setFont (juce::FontOptions (11.0f));
+        auto rowHeight = juce::jmin (24, area.getHeight() / StageProfiler::numStages);
+        for (int s = 0; s < StageProfiler::numStages; ++s)
+        {
+            auto row = area.removeFromTop (rowHeight);
+            auto bar = row.removeFromBottom (4).toFloat();
+            g.setColour (juce::Colour (0xFF2D2D2D));
+            g.fillRect (bar);
+            g.setColour (juce::Colour (0xFF4DB8FF));
+            g.fillRect (bar.withWidth (bar.getWidth() * (float) (std::log2 ((double) stats[s].p99Cycles + 1.0) / worst)));
+
+            auto cell = [] (std::uint64_t v) { return juce::String ((juce::int64) v).paddedLeft (' ', 9); };
+            g.setColour (juce::Colour (0xFFE0E0E0));
+            g.drawText (juce::String (StageProfiler::getStageName (s)).toUpperCase().paddedRight (' ', 16)
+                          + cell (stats[s].meanCycles) + cell (stats[s].p50Cycles) + cell (stats[s].p99Cycles) + cell (stats[s].maxCycles),
+                        row, juce::Justification::centredLeft);
+        }
+    }
+
+private:
+    StageProfiler& profiler;
+};
+#endif
+
 class NewLouderSaturator_Feb21AudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Timer
 {
 public:
@@ -104,27 +159,47 @@ public:
     void timerCallback() override;
 
 private:
+    void refreshChainButtons();
+
     // IMPORTANT: This must remain at the top of the private section!
     CustomLookAndFeel customLookAndFeel;
     
     juce::Slider inputSlider, driveSlider, reverbSlider, toneSlider;
     juce::Slider decaySlider, dampingSlider, widthSlider, mixSlider, outputSlider; 
+    juce::Slider ceilingSlider;
     juce::ToggleButton prePostButton, bypassButton;
-    juce::ComboBox reverbTypeCombo; 
+    juce::ComboBox reverbTypeCombo, satModelCombo, offlineQualityCombo, bypassTailCombo, reverbDecimateCombo, reverbStorageCombo, governorCombo, limiterCombo; 
 
     juce::Label satSectionLabel, revSectionLabel;
 
+    // Processing order strip: clicking a module moves it one slot later (the last one wraps to the front).
+    juce::Label chainLabel;
+    juce::TextButton chainButtons[(size_t) NewLouderSaturator_Feb21AudioProcessor::Module::numModules];
+
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> inputAttachment, driveAttachment, reverbAttachment, toneAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> decayAttachment, dampingAttachment, widthAttachment, mixAttachment, outputAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ceilingAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> prePostAttachment, bypassAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> typeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> typeAttachment, satModelAttachment, offlineQualityAttachment, bypassTailAttachment, reverbDecimateAttachment, reverbStorageAttachment, governorAttachment, limiterAttachment;
 
     juce::Label inputLabel, driveLabel, reverbLabel, toneLabel;
     juce::Label decayLabel, dampingLabel, widthLabel, mixLabel, outputLabel;
 
     NewLouderSaturator_Feb21AudioProcessor& audioProcessor;
+
+    // Standalone app only; null in plugin hosts.
+    std::unique_ptr<StandaloneDiagnostics> diagnostics;
+    juce::TextButton diagnosticsButton { "DIAG" };
+
+   #if LOUDER_ENABLE_PROFILER
+    ProfilerOverlay profilerOverlay { audioProcessor.profiler };
+    juce::TextButton profilerButton { "PERF" }, traceButton { "TRACE" };
+    std::unique_ptr<StageProfiler::TraceWriter> traceWriter;
+   #endif
+
     float smoothInputLevel = 0.0f;
     float smoothOutputLevel = 0.0f;
+    float smoothReductionDb = 0.0f;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NewLouderSaturator_Feb21AudioProcessorEditor)
 };
\ No newline at end of file
@@ -1,6 +1,69 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    // Realtime stays lean for tracking. Offline renders (isNonRealtime) pick up the profile chosen with
+    // the "offlineQuality" parameter: exact curves, oversampled drive and a denser reverb tail.
+    struct QualityProfile
+    {
+        Saturation::Quality saturation;
+        int oversamplingOrder;   // 0 = off, 1 = 2x, 2 = 4x
+        int reverbDensity;       // RoomReverb comb groups
+    };
+
+    const QualityProfile realtimeProfile { Saturation::Quality::Table, 0, RoomReverb::defaultGroups };
+
+    const QualityProfile offlineProfiles[] =
+    {
+        realtimeProfile,
+        { Saturation::Quality::Exact, 1, RoomReverb::maxGroups },
+        { Saturation::Quality::Exact, 2, RoomReverb::maxGroups }
+    };
+
+    const QualityProfile& selectProfile (bool nonRealtime, int offlineChoice) noexcept
+    {
+        if (! nonRealtime) return realtimeProfile;
+        return offlineProfiles[juce::jlimit (0, (int) std::size (offlineProfiles) - 1, offlineChoice)];
+    }
+
+    // True when L and R are bit-identical, or differ by no more than -80 dB of the block peak.
+    // Exits on the first differing sample, so genuinely stereo material costs next to nothing.
+    bool channelsMatch (const float* left, const float* right, int numSamples, float peak) noexcept
+    {
+        if (std::memcmp (left, right, sizeof (float) * (size_t) numSamples) == 0)
+            return true;
+
+        const float tolerance = juce::jmax (peak * 1.0e-4f, 1.0e-7f);
+        for (int i = 0; i < numSamples; ++i)
+            if (std::abs (left[i] - right[i]) > tolerance)
+                return false;
+
+        return true;
+    }
+
+    // Pushes the channels through 'delay' in place, one sample at a time.
+    void delayInPlace (juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>& delay,
+                       juce::AudioBuffer<float>& buffer, int firstChannel, int numChannels, int numSamples) noexcept
+    {
+        for (int ch = firstChannel; ch < firstChannel + numChannels; ++ch) {
+            auto* data = buffer.getWritePointer (ch);
+            for (int sample = 0; sample < numSamples; ++sample) {
+                delay.pushSample (ch, data[sample]);
+                data[sample] = delay.popSample (ch);
+            }
+        }
+    }
+
+    void expandToStereo (juce::AudioBuffer<float>& buffer, int& activeChannels, int numChannels, int numSamples) noexcept
+    {
+        if (activeChannels < numChannels) {
+            buffer.copyFrom (1, 0, buffer, 0, 0, numSamples);
+            activeChannels = numChannels;
+        }
+    }
+}
+
 NewLouderSaturator_Feb21AudioProcessor::NewLouderSaturator_Feb21AudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
      : AudioProcessor (BusesProperties()
@@ -15,8 +78,32 @@ NewLouderSaturator_Feb21AudioProcessor::NewLouderSaturator_Feb21AudioProcessor()
 #else
      : apvts (*this, nullptr, "Parameters", createParameterLayout())
 #endif
-{}
-NewLouderSaturator_Feb21AudioProcessor::~NewLouderSaturator_Feb21AudioProcessor() {}
+{
+    compileChain();
+
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            apvts.addParameterListener (ranged->getParameterID(), this);
+
+    parameterPoller->add (*this);
+
+    // The standalone app is where buffer sizes get tuned, so it watches its own deadline.
+    callbackMonitor.setEnabled (wrapperType == wrapperType_Standalone);
+
+   #if LOUDER_CLAP_EXTENSIONS
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            clapParameters.push_back ({ (clap_id) ranged->getParameterID().hashCode(), ranged });
+   #endif
+}
+NewLouderSaturator_Feb21AudioProcessor::~NewLouderSaturator_Feb21AudioProcessor()
+{
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            apvts.removeParameterListener (ranged->getParameterID(), this);
+
+    parameterPoller->remove (*this);
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout NewLouderSaturator_Feb21AudioProcessor::createParameterLayout()
 {
@@ -26,13 +113,18 @@ juce::AudioProcessorValueTreeState::ParameterLayout NewLouderSaturator_Feb21Audi
     gainRange.setSkewForCentre(0.0f); 
 
     layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "bypass", 1 }, "Bypass", false));
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "bypassTail", 1 }, "Bypass Tail", juce::StringArray { "Ring Out", "Flush" }, 0));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "input", 1 }, "Input", gainRange, 0.0f));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "drive", 1 }, "Drive", 0.0f, 10.0f, 0.0f));
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "satModel", 1 }, "Saturation", Saturation::modelNames, 0));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "reverb", 1 }, "Reverb", 0.0f, 100.0f, 0.0f));
     
     // ---> THE FIX: Proper Bool parameter and renamed ID to bust Ableton's cache <---
     layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "prePostSwitch", 1 }, "Pre/Post", false));
     
+    layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "reverbDecimate", 1 }, "Reverb Decimation", false));
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "reverbStorage", 1 }, "Reverb Memory", juce::StringArray { "32-bit", "16-bit" }, 0,
+                                                              juce::AudioParameterChoiceAttributes().withAutomatable (false)));
     layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "reverbType", 1 }, "Reverb Type", juce::StringArray { "Room", "Hall", "Plate" }, 0));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "decay", 1 }, "Decay", 0.0f, 100.0f, 50.0f));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "damping", 1 }, "Damping", 0.0f, 100.0f, 50.0f));
@@ -40,6 +132,13 @@ juce::AudioProcessorValueTreeState::ParameterLayout NewLouderSaturator_Feb21Audi
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "width", 1 }, "Width", 0.0f, 200.0f, 100.0f));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "mix", 1 }, "Mix", 0.0f, 100.0f, 100.0f));
     layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "output", 1 }, "Output", gainRange, 0.0f));
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "offlineQuality", 1 }, "Offline Quality", juce::StringArray { "Realtime", "High", "Ultra" }, 1));
+    layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "governor", 1 }, "CPU Governor", false,
+                                                            juce::AudioParameterBoolAttributes().withAutomatable (false)));
+    layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "limiter", 1 }, "Limiter", false,
+                                                            juce::AudioParameterBoolAttributes().withAutomatable (false)));
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "ceiling", 1 }, "Ceiling", juce::NormalisableRange<float> (-12.0f, 0.0f, 0.1f), -1.0f,
+                                                             juce::AudioParameterFloatAttributes().withStringFromValueFunction ([] (float value, int) { return juce::String (value, 1) + " dB"; })));
     return layout;
 }
 
@@ -47,7 +146,39 @@ const juce::String NewLouderSaturator_Feb21AudioProcessor::getName() const { ret
 bool NewLouderSaturator_Feb21AudioProcessor::acceptsMidi() const { return false; }
 bool NewLouderSaturator_Feb21AudioProcessor::producesMidi() const { return false; }
 bool NewLouderSaturator_Feb21AudioProcessor::isMidiEffect() const { return false; }
-double NewLouderSaturator_Feb21AudioProcessor::getTailLengthSeconds() const { return 1.0; } 
+// Time for the reverb to fall 60 dB at the current settings, plus a little for the filters.
+double NewLouderSaturator_Feb21AudioProcessor::getTailLengthSeconds() const
+{
+    return RoomReverb::getDecayTimeSeconds (computeReverbParameters(), 60.0) + 0.1;
+}
+
+RoomReverb::Parameters NewLouderSaturator_Feb21AudioProcessor::computeReverbParameters() const
+{
+    float reverbAmount = apvts.getRawParameterValue("reverb")->load() / 100.0f;
+    float type = apvts.getRawParameterValue("reverbType")->load();
+    float decay = apvts.getRawParameterValue("decay")->load() / 100.0f;
+    float damping = apvts.getRawParameterValue("damping")->load() / 100.0f;
+
+    RoomReverb::Parameters params;
+    if (type == 0.0f) { // Room
+        params.roomSize = decay * 0.5f; 
+        params.damping = damping * 0.6f;
+        params.width = 0.8f;
+    } else if (type == 1.0f) { // Hall
+        params.roomSize = 0.5f + (decay * 0.5f); 
+        params.damping = damping * 0.8f;
+        params.width = 1.0f;
+    } else { // Plate
+        params.roomSize = decay * 0.7f;
+        params.damping = 0.2f + (damping * 0.7f); 
+        params.width = 0.5f; 
+    }
+    params.wetLevel = reverbAmount;
+    params.dryLevel = 1.0f;
+    params.freezeMode = 0.0f;
+    return params;
+}
+juce::AudioProcessorParameter* NewLouderSaturator_Feb21AudioProcessor::getBypassParameter() const { return apvts.getParameter ("bypass"); }
 int NewLouderSaturator_Feb21AudioProcessor::getNumPrograms() { return 1; }
 int NewLouderSaturator_Feb21AudioProcessor::getCurrentProgram() { return 0; }
 void NewLouderSaturator_Feb21AudioProcessor::setCurrentProgram (int index) {}
@@ -56,24 +187,275 @@ void NewLouderSaturator_Feb21AudioProcessor::changeProgramName (int index, const
 
 void NewLouderSaturator_Feb21AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    reverb.setSampleRate (sampleRate);
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = (juce::uint32) samplesPerBlock;
-    spec.numChannels = 1; 
+    {
+        const std::lock_guard<std::mutex> lock (coefficientLock);
+        resources = resourceCache->get (sampleRate);
+        kernels = &Kernels::getTable (Kernels::getBestIsa());
+    }
+
+    // Hosts flag offline bounces before preparing, so this is the one place the oversampling factor
+    // (and with it the latency) and the reverb's delay memory are decided. A later realtime/offline
+    // flip without a re-prepare only switches what fits inside those limits.
+    const auto& profile = selectProfile (isNonRealtime(), (int) apvts.getRawParameterValue ("offlineQuality")->load());
+
+    reverb.setSampleRate (sampleRate, profile.reverbDensity, getSelectedReverbStorage());
     for (int i = 0; i < 2; ++i) {
-        toneFilter[i].prepare (spec);
-        toneFilter[i].setType (juce::dsp::StateVariableTPTFilterType::lowpass);
+        toneFilter[i].setType (ToneFilter::Type::lowpass);
         toneFilter[i].reset();
+        driveDcBlocker[i].prepare (sampleRate);
     }
     
     dryBuffer.setSize (2, samplesPerBlock);
+
+    for (auto& oversampler : oversamplers)
+    {
+        oversampler.reset();
+        if (profile.oversamplingOrder > 0) {
+            oversampler = std::make_unique<juce::dsp::Oversampling<float>> (1, (size_t) profile.oversamplingOrder,
+                                                                             juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+            oversampler->initProcessing ((size_t) samplesPerBlock);
+        }
+    }
+
+    oversamplingLatency = oversamplers[0] != nullptr ? (int) oversamplers[0]->getLatencyInSamples() : 0;
+
+    dryDelay.setMaximumDelayInSamples (juce::jmax (1, oversamplingLatency));
+    dryDelay.prepare ({ sampleRate, (juce::uint32) samplesPerBlock, 2 });
+    dryDelay.setDelay ((float) oversamplingLatency);
+
+    // Sized for the limiter either way, so switching it later doesn't allocate.
+    limiter.prepare (sampleRate, samplesPerBlock, *kernels);
+    limiterEnabled = isLimiterSelected();
+    limiterGain.store (1.0f);
+
+    bypassDelay.setMaximumDelayInSamples (juce::jmax (1, oversamplingLatency + limiter.getLatencyInSamples()));
+    bypassDelay.prepare ({ sampleRate, (juce::uint32) samplesPerBlock, 2 });
+    updateLatency();
+    bypassBuffer.setSize (2, samplesPerBlock);
+    bypassRamp.assign ((size_t) samplesPerBlock, 0.0f);
+
+    // Start wherever the switch already is; only toggles after this point are ramped.
+    const bool bypassed = apvts.getRawParameterValue ("bypass")->load() > 0.5f;
+    bypassMix.reset (sampleRate, 0.02);
+    bypassMix.setCurrentAndTargetValue (bypassed ? 0.0f : 1.0f);
+    wasBypassed = bypassed;
+    tailRinging = false;
+    chainIdle = false;
+
+    preparedBlockSize = samplesPerBlock;
+    preparedSampleRate = sampleRate;
+
+    reverbDecimationStages = sampleRate >= 176400.0 ? 2 : (sampleRate >= 88200.0 ? 1 : 0);
+    reverbScratch.setSize (2, samplesPerBlock);
+    reverbResampler.setNumStages (0);
+    setReverbDecimation (apvts.getRawParameterValue ("reverbDecimate")->load() > 0.5f && getTotalNumOutputChannels() > 1);
+
+    // Roughly 100 ms of matching input before we trust that a bus is really carrying mono.
+    monoEntryBlocks = juce::jmax (1, (int) std::ceil (0.1 * sampleRate / juce::jmax (1, samplesPerBlock)));
+    monoContent = false;
+    matchingBlocks = 0;
+    rightToneStateStale = false;
+    rightDcStateStale = false;
+
+    // The tone coefficients depend on the rate, so start from a fresh set and apply it in full on
+    // the first block, without ramping the gains in from stale values.
+    updateCoefficients (true);
+    if (const auto* set = coefficients.acquire()) {
+        appliedInputGain = set->inputGain;
+        appliedDrive = set->drive;
+        appliedMix = set->mix;
+        appliedOutputGain = set->outputGain;
+        appliedReverbDry = set->reverb.dryGain;
+    }
+    offlineCoefficients.generation = 0;
+    appliedGeneration = 0;
+
+    governor.prepare (sampleRate, samplesPerBlock);
+    governorActive = false;
+    governorTier.store (0);
+    governorLoad.store (0.0f);
+
+    callbackMonitor.prepare (sampleRate);
+
+    DBG (getMemoryFootprintReport());
+    DBG ("LOUDER kernels: " << Kernels::getIsaName (kernels->isa));
 }
 
 void NewLouderSaturator_Feb21AudioProcessor::releaseResources()
 {
     reverb.reset();
     for (int i = 0; i < 2; ++i) toneFilter[i].reset();
+    for (auto& blocker : driveDcBlocker) blocker.reset();
+    for (auto& oversampler : oversamplers) if (oversampler != nullptr) oversampler->reset();
+    dryDelay.reset();
+    bypassDelay.reset();
+    limiter.reset();
+}
+
+RoomReverb::Storage NewLouderSaturator_Feb21AudioProcessor::getSelectedReverbStorage() const
+{
+    return apvts.getRawParameterValue ("reverbStorage")->load() > 0.5f ? RoomReverb::Storage::float16
+                                                                         : RoomReverb::Storage::float32;
+}
+
+bool NewLouderSaturator_Feb21AudioProcessor::isLimiterSelected() const
+{
+    return apvts.getRawParameterValue ("limiter")->load() > 0.5f;
+}
+
+// Reports the chain's total latency and delays the bypass path to match. Only while the audio
+// thread can't run: from prepareToPlay, or with processing suspended.
+void NewLouderSaturator_Feb21AudioProcessor::updateLatency()
+{
+    latencySamples = oversamplingLatency + (limiterEnabled ? limiter.getLatencyInSamples() : 0);
+    setLatencySamples (latencySamples);
+    bypassDelay.setDelay ((float) latencySamples);
+}
+
+// Can be called on the audio thread while automation plays (a CLAP direct process call applies its
+// events through here too), so all it does is flag the coefficients as out of date. The shared
+// poller notices on the message thread; repeated changes before then collapse into one update.
+void NewLouderSaturator_Feb21AudioProcessor::parameterChanged (const juce::String&, float)
+{
+    parameterGeneration.fetch_add (1, std::memory_order_acq_rel);
+}
+
+// Message thread (or prepareToPlay). Builds a complete set and publishes it unless nothing has
+// changed since the last one; the audio thread picks it up at the start of its next block.
+void NewLouderSaturator_Feb21AudioProcessor::updateCoefficients (bool force)
+{
+    const std::lock_guard<std::mutex> lock (coefficientLock);
+    if (resources == nullptr || (! force && parameterGeneration.load (std::memory_order_acquire) == publishedGeneration))
+        return;
+
+    auto set = std::make_unique<CoefficientSet>();
+    computeCoefficients (*set);
+    publishedGeneration = set->generation;
+    coefficients.publish (std::move (set));
+}
+
+// Doesn't allocate or lock, so offline renders can call it from the audio thread. The generation is
+// read first: a change that lands while we read the values bumps it again and gets its own set.
+void NewLouderSaturator_Feb21AudioProcessor::computeCoefficients (CoefficientSet& set) const noexcept
+{
+    set.generation = parameterGeneration.load (std::memory_order_acquire);
+
+    const float inDB = apvts.getRawParameterValue ("input")->load();
+    const float outDB = apvts.getRawParameterValue ("output")->load();
+    set.inputGain = (inDB <= -99.0f) ? 0.0f : juce::Decibels::decibelsToGain (inDB);
+    set.outputGain = (outDB <= -99.0f) ? 0.0f : juce::Decibels::decibelsToGain (outDB);
+    set.drive = apvts.getRawParameterValue ("drive")->load();
+    set.width = apvts.getRawParameterValue ("width")->load() / 100.0f;
+    set.mix = apvts.getRawParameterValue ("mix")->load() / 100.0f;
+
+    const float tone = apvts.getRawParameterValue ("tone")->load();
+    set.toneActive = tone != 0.0f;
+    set.toneType = tone < 0.0f ? ToneFilter::Type::lowpass : ToneFilter::Type::highpass;
+    set.toneCoefficient = resources->getToneCoefficient (tone);
+
+    set.reverb = RoomReverb::computeCoefficients (computeReverbParameters());
+    set.decimateReverb = apvts.getRawParameterValue ("reverbDecimate")->load() > 0.5f;
+    set.chainVariant = apvts.getRawParameterValue ("prePostSwitch")->load() < 0.5f ? 0 : 1;
+    set.governorEnabled = apvts.getRawParameterValue ("governor")->load() > 0.5f;
+    set.limiterCeiling = juce::Decibels::decibelsToGain (apvts.getRawParameterValue ("ceiling")->load());
+
+    const int model = (int) apvts.getRawParameterValue ("satModel")->load();
+    set.dcBlock = Saturation::needsDcBlocker (model);
+    const int offlineChoice = (int) apvts.getRawParameterValue ("offlineQuality")->load();
+    for (int nonRealtime = 0; nonRealtime < 2; ++nonRealtime)
+    {
+        const auto& profile = selectProfile (nonRealtime == 1, offlineChoice);
+        set.saturate[nonRealtime] = Kernels::getSaturation (*kernels, model, profile.saturation);
+        set.reverbDensity[nonRealtime] = profile.reverbDensity;
+    }
+}
+
+// Message thread, from the shared poller. Publishes a new coefficient set if any parameter has moved
+// since the last poll, and does nothing else otherwise.
+//
+// A new storage format means reallocating the delay lines, and switching the limiter changes the
+// latency, neither of which can happen under the audio thread. So they're done here with processing
+// suspended for the moment it takes. A new storage format clears the reverb tail. "reverbStorage"
+// and "limiter" aren't automatable, so those only change from the editor or a state load.
+void NewLouderSaturator_Feb21AudioProcessor::pollParameters()
+{
+    const auto generation = parameterGeneration.load (std::memory_order_acquire);
+    if (generation == polledGeneration)
+        return;
+
+    polledGeneration = generation;
+    updateCoefficients (false);
+    coefficients.collectGarbage();
+
+    const auto storage = getSelectedReverbStorage();
+    const bool limiterOn = isLimiterSelected();
+    if (storage == reverb.getStorage() && limiterOn == limiterEnabled)
+        return;
+
+    suspendProcessing (true);
+
+    if (storage != reverb.getStorage())
+        reverb.setStorage (storage);
+
+    if (limiterOn != limiterEnabled) {
+        limiterEnabled = limiterOn;
+        limiter.reset();
+        if (preparedBlockSize > 0) updateLatency();
+    }
+
+    suspendProcessing (false);
+}
+
+// Audio thread safe. Switching clears the reverb tail, which is fine for a setup option.
+void NewLouderSaturator_Feb21AudioProcessor::setReverbDecimation (bool enabled) noexcept
+{
+    const int stages = enabled ? reverbDecimationStages : 0;
+    if (stages == reverbResampler.getNumStages())
+        return;
+
+    reverbResampler.setNumStages (stages);
+    reverb.setProcessingRate (preparedSampleRate / reverbResampler.getFactor());
+}
+
+// The combs only ever see the L+R sum, so that's all we decimate; the stereo wet output is
+// interpolated back up and added to the full-rate dry signal.
+void NewLouderSaturator_Feb21AudioProcessor::processReverbDecimated (juce::AudioBuffer<float>& buffer, int numSamples, float dryStart, float dryGain) noexcept
+{
+    if (reverbScratch.getNumSamples() < numSamples) {
+        reverbScratch.setSize (2, numSamples, false, false, true);
+    }
+
+    auto* left = buffer.getWritePointer (0);
+    auto* right = buffer.getWritePointer (1);
+    auto* wetLeft = reverbScratch.getWritePointer (0);
+    auto* wetRight = reverbScratch.getWritePointer (1);
+
+    juce::FloatVectorOperations::add (wetLeft, left, right, numSamples);
+    const int decimatedSamples = reverbResampler.down (wetLeft, wetLeft, numSamples);
+    reverb.processStereoWet (wetLeft, wetRight, decimatedSamples);
+
+    // The dry path ramps across the block like the chain's other gains, rather than jumping to the new value.
+    buffer.applyGainRamp (0, 0, numSamples, dryStart, dryGain);
+    buffer.applyGainRamp (1, 0, numSamples, dryStart, dryGain);
+    reverbResampler.upAdd (wetLeft, wetRight, left, right, numSamples);
+}
+
+// Clears everything that carries signal history, so a later un-bypass starts from silence
+// instead of resuming a frozen reverb tail.
+void NewLouderSaturator_Feb21AudioProcessor::flushProcessingState() noexcept
+{
+    reverb.reset();
+    reverbResampler.reset();
+    for (int i = 0; i < 2; ++i) toneFilter[i].reset();
+    for (auto& blocker : driveDcBlocker) blocker.reset();
+    for (auto& oversampler : oversamplers) if (oversampler != nullptr) oversampler->reset();
+    dryDelay.reset();
+    limiter.reset();
+
+    monoContent = false;
+    matchingBlocks = 0;
+    rightToneStateStale = false;
+    rightDcStateStale = false;
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -100,155 +482,524 @@ void NewLouderSaturator_Feb21AudioProcessor::processBlock (juce::AudioBuffer<flo
     juce::ScopedNoDenormals noDenormals;
     auto numSamples = buffer.getNumSamples();
     auto numChannels = buffer.getNumChannels(); 
+    CallbackMonitor::Scope callbackScope (callbackMonitor, numSamples);
 
     if (numChannels == 0 || numSamples == 0) return;
 
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    bool governing = false;
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
         if (i < numChannels) buffer.clear (i, 0, numSamples);
     }
 
+    const auto* compiled = routing.acquire();
+    const auto* set = coefficients.acquire();
+
+    const bool isBypassed = apvts.getRawParameterValue("bypass")->load() > 0.5f;
+    const bool ringOut = apvts.getRawParameterValue("bypassTail")->load() < 0.5f;
+
+    if (isBypassed && ! wasBypassed) {
+        tailRinging = ringOut;
+        silentTailBlocks = 0;
+    }
+    if (! isBypassed || ! ringOut) tailRinging = false;
+    wasBypassed = isBypassed;
+
+    bypassMix.setTargetValue (isBypassed ? 0.0f : 1.0f);
+    const bool ramping = bypassMix.isSmoothing();
+
+    // Fully bypassed with nothing left to ring out: the input passes through untouched (or just
+    // delayed, if we report latency) and nothing else runs, metering included.
+    if (isBypassed && ! ramping && ! tailRinging)
+    {
+        if (! chainIdle) {
+            flushProcessingState();
+            inputLevel.store (0.0f);
+            outputLevel.store (0.0f);
+            limiterGain.store (1.0f);
+            chainIdle = true;
+        }
+
+        if (latencySamples > 0) delayInPlace (bypassDelay, buffer, 0, juce::jmin (numChannels, 2), numSamples);
+        return;
+    }
+    chainIdle = false;
+
+    LOUDER_PROFILE_BEGIN_BLOCK (profiler);
+
     float maxInput = 0.0f;
-    for (int ch = 0; ch < numChannels; ++ch) {
-        maxInput = juce::jmax(maxInput, buffer.getMagnitude(ch, 0, numSamples));
+    {
+        LOUDER_PROFILE_STAGE (profiler, inputMeter);
+        for (int ch = 0; ch < numChannels; ++ch) {
+            maxInput = juce::jmax(maxInput, buffer.getMagnitude(ch, 0, numSamples));
+        }
+        inputLevel.store(maxInput);
     }
-    inputLevel.store(maxInput);
 
-    bool isBypassed = apvts.getRawParameterValue("bypass")->load() > 0.5f;
+    // While bypassing (or coming back) the latency-aligned input is kept aside for the crossfade.
+    // With latency the delay line is fed every block so its history is valid when a ramp starts.
+    const bool mixesBypassDry = isBypassed || ramping;
+    const int bypassChannels = juce::jmin (numChannels, 2);
 
-    if (!isBypassed) 
+    if (mixesBypassDry || latencySamples > 0)
     {
-        float inDB = apvts.getRawParameterValue("input")->load();
-        float inputGain = (inDB <= -99.0f) ? 0.0f : juce::Decibels::decibelsToGain(inDB);
-        buffer.applyGain(inputGain);
-
-        float drive = apvts.getRawParameterValue("drive")->load();
-        float reverbAmount = apvts.getRawParameterValue("reverb")->load() / 100.0f;
-        
-        // ---> THE FIX: Reading the new ID <---
-        float prePost = apvts.getRawParameterValue("prePostSwitch")->load();
-        
-        float type = apvts.getRawParameterValue("reverbType")->load();
-        float decay = apvts.getRawParameterValue("decay")->load() / 100.0f;
-        float damping = apvts.getRawParameterValue("damping")->load() / 100.0f;
-        float tone = apvts.getRawParameterValue("tone")->load();
-        float width = apvts.getRawParameterValue("width")->load() / 100.0f; 
-        float mix = apvts.getRawParameterValue("mix")->load() / 100.0f;
-        float outDB = apvts.getRawParameterValue("output")->load();
-        float outputGain = (outDB <= -99.0f) ? 0.0f : juce::Decibels::decibelsToGain(outDB);
-
-        if (type == 0.0f) { // Room
-            reverbParameters.roomSize = decay * 0.5f; 
-            reverbParameters.damping = damping * 0.6f;
-            reverbParameters.width = 0.8f;
-        } else if (type == 1.0f) { // Hall
-            reverbParameters.roomSize = 0.5f + (decay * 0.5f); 
-            reverbParameters.damping = damping * 0.8f;
-            reverbParameters.width = 1.0f;
-        } else { // Plate
-            reverbParameters.roomSize = decay * 0.7f;
-            reverbParameters.damping = 0.2f + (damping * 0.7f); 
-            reverbParameters.width = 0.5f; 
+        if (bypassBuffer.getNumSamples() < numSamples) {
+            bypassBuffer.setSize (2, numSamples, false, false, true);
         }
-        reverbParameters.wetLevel = reverbAmount;
-        reverbParameters.dryLevel = 1.0f;
-        reverbParameters.freezeMode = 0.0f;
+        for (int ch = 0; ch < bypassChannels; ++ch)
+            bypassBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+        if (latencySamples > 0) delayInPlace (bypassDelay, bypassBuffer, 0, bypassChannels, numSamples);
+    }
+
+    if (ramping)
+    {
+        if ((int) bypassRamp.size() < numSamples) bypassRamp.resize ((size_t) numSamples);
+        for (int i = 0; i < numSamples; ++i) bypassRamp[(size_t) i] = bypassMix.getNextValue();
+    }
+
+    // Ring Out fades the chain's input instead of its output, so the reverb (and anything after
+    // it) keeps sounding on top of the dry signal until the tail has died away.
+    if (ringOut && mixesBypassDry)
+    {
+        if (ramping) {
+            for (int ch = 0; ch < numChannels; ++ch) {
+                auto* data = buffer.getWritePointer (ch);
+                for (int i = 0; i < numSamples; ++i) data[i] *= bypassRamp[(size_t) i];
+            }
+        } else {
+            buffer.clear();
+        }
+    }
+
+    if (compiled != nullptr && set != nullptr)
+    {
+        updateMonoDetection (buffer, numSamples, maxInput);
+
+        const bool nonRealtime = isNonRealtime();
+
+        // Offline there's no deadline and the message thread may lag far behind the render, so
+        // automation is followed block by block here instead. A CLAP direct process call does the
+        // same for each of its sub-blocks.
+        if (nonRealtime || followParametersInline)
+        {
+            if (offlineCoefficients.generation != parameterGeneration.load (std::memory_order_acquire))
+                computeCoefficients (offlineCoefficients);
+            set = &offlineCoefficients;
+        }
+
+        // Channels the per-channel stages need to touch. Drops to 1 for dual-mono input; the
+        // reverb always runs in stereo so its decorrelated tail stays intact.
+        BlockContext context { buffer, numSamples, numChannels, monoContent ? 1 : numChannels,
+                               *set, set->saturate[nonRealtime ? 1 : 0], set->generation != appliedGeneration,
+                               appliedInputGain, appliedDrive, appliedMix, appliedOutputGain, appliedReverbDry };
+
+        // Offline there's no deadline to protect, so the governor only runs live.
+        const int density = set->reverbDensity[nonRealtime ? 1 : 0];
+        governing = set->governorEnabled && ! nonRealtime;
+        if (governing) {
+            governor.setMaxTier (density - 1);
+        } else if (governorActive) {
+            governor.reset();
+            governorTier.store (0);
+            governorLoad.store (0.0f);
+        }
+        governorActive = governing;
+
+        reverb.setDensity (density - governor.getTier());
 
         if (dryBuffer.getNumSamples() < numSamples) {
             dryBuffer.setSize (2, numSamples, false, false, true); 
         }
-        for (int ch = 0; ch < numChannels; ++ch) {
-            if (ch < 2) dryBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+        const auto& chain = compiled->variants[set->chainVariant];
+        for (int i = 0; i < chain.numStages; ++i)
+        {
+            const auto& stage = chain.stages[(size_t) i];
+            LOUDER_PROFILE_STAGE_ID (profiler, stage.profileId);
+            stage.process (*this, context);
         }
 
-        if (prePost < 0.5f) // PRE
+        appliedGeneration = set->generation;
+        appliedInputGain = set->inputGain;
+        appliedDrive = set->drive;
+        appliedMix = set->mix;
+        appliedOutputGain = set->outputGain;
+        appliedReverbDry = set->reverb.dryGain;
+    } 
+
+    if (tailRinging && ! ramping)
+    {
+        float tailLevel = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch)
+            tailLevel = juce::jmax (tailLevel, buffer.getMagnitude (ch, 0, numSamples));
+
+        // -100 dB for as long as mono detection waits (~100 ms) counts as rung out.
+        silentTailBlocks = tailLevel < 1.0e-5f ? silentTailBlocks + 1 : 0;
+        if (silentTailBlocks >= monoEntryBlocks) tailRinging = false;
+    }
+
+    if (mixesBypassDry)
+    {
+        for (int ch = 0; ch < bypassChannels; ++ch)
         {
-            reverb.setParameters(reverbParameters);
-            if (numChannels > 1) {
-                reverb.processStereo(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples);
+            auto* out = buffer.getWritePointer (ch);
+            const auto* dry = bypassBuffer.getReadPointer (ch);
+
+            if (! ramping) {
+                for (int i = 0; i < numSamples; ++i) out[i] += dry[i];
+            } else if (ringOut) {
+                for (int i = 0; i < numSamples; ++i) out[i] += dry[i] * (1.0f - bypassRamp[(size_t) i]);
             } else {
-                reverb.processMono(buffer.getWritePointer(0), numSamples);
+                for (int i = 0; i < numSamples; ++i) out[i] = dry[i] + (out[i] - dry[i]) * bypassRamp[(size_t) i];
             }
+        }
+    }
 
-            if (drive > 0.0f) {
-                for (int channel = 0; channel < numChannels; ++channel) {
-                    auto* channelData = buffer.getWritePointer(channel);
-                    for (int sample = 0; sample < numSamples; ++sample)
-                        channelData[sample] = std::tanh(channelData[sample] * (1.0f + drive));
-                }
-            }
+    {
+        LOUDER_PROFILE_STAGE (profiler, outputMeter);
+        float maxOutput = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch) {
+            maxOutput = juce::jmax(maxOutput, buffer.getMagnitude(ch, 0, numSamples));
         }
-        else // POST
-        {
-            if (drive > 0.0f) {
-                for (int channel = 0; channel < numChannels; ++channel) {
-                    auto* channelData = buffer.getWritePointer(channel);
-                    for (int sample = 0; sample < numSamples; ++sample)
-                        channelData[sample] = std::tanh(channelData[sample] * (1.0f + drive));
-                }
-            }
+        outputLevel.store(maxOutput);
+    }
 
-            reverb.setParameters(reverbParameters);
-            if (numChannels > 1) {
-                reverb.processStereo(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples);
-            } else {
-                reverb.processMono(buffer.getWritePointer(0), numSamples);
-            }
+    if (governing)
+    {
+        const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - blockStartTicks);
+        governorTier.store (governor.process (seconds, numSamples / preparedSampleRate));
+        governorLoad.store (governor.getLoad());
+    }
+
+    LOUDER_PROFILE_END_BLOCK (profiler);
+}
+
+//==============================================================================
+// Chain stages. Each one reads and updates the shared BlockContext; activeChannels is 1 while the
+// input is dual-mono and the output stage copies the left channel back to the right at the end.
+
+void NewLouderSaturator_Feb21AudioProcessor::gainStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    for (int ch = 0; ch < c.activeChannels; ++ch)
+        p.kernels->gainRamp (c.buffer.getWritePointer (ch), c.numSamples, c.inputGainStart, c.coefficients.inputGain);
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::dryTapStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    for (int ch = 0; ch < c.activeChannels; ++ch) {
+        if (ch < 2) p.dryBuffer.copyFrom (ch, 0, c.buffer, ch, 0, c.numSamples);
+    }
+
+    if (p.oversamplingLatency > 0) delayInPlace (p.dryDelay, p.dryBuffer, 0, juce::jmin (c.numChannels, 2), c.numSamples);
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::reverbStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    if (c.coefficientsChanged) p.reverb.setCoefficients (c.coefficients.reverb);
+    p.setReverbDecimation (c.coefficients.decimateReverb && c.numChannels > 1);
+    expandToStereo (c.buffer, c.activeChannels, c.numChannels, c.numSamples);
+    if (p.reverbResampler.getNumStages() > 0) {
+        p.processReverbDecimated (c.buffer, c.numSamples, c.reverbDryStart, c.coefficients.reverb.dryGain);
+    } else if (c.numChannels > 1) {
+        p.reverb.processStereo(c.buffer.getWritePointer(0), c.buffer.getWritePointer(1), c.numSamples);
+    } else {
+        p.reverb.processMono(c.buffer.getWritePointer(0), c.numSamples);
+    }
+    if (p.monoContent && p.reverb.isWetSilent()) c.activeChannels = 1;
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::driveStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    p.processDrive (c.buffer, c.activeChannels, c.numSamples, c.saturate, c.driveStart, c.coefficients.drive, c.coefficients.dcBlock);
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::toneStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    if (! c.coefficients.toneActive) return;
+
+    if (c.coefficientsChanged) {
+        for (int i = 0; i < 2; ++i) {
+            p.toneFilter[i].setType (c.coefficients.toneType);
+            p.toneFilter[i].setCoefficient (c.coefficients.toneCoefficient);
         }
+    }
+
+    // Inputs were identical while only the left filter ran, so its state is the right one's too.
+    if (c.activeChannels > 1 && p.rightToneStateStale) p.toneFilter[1] = p.toneFilter[0];
+    p.rightToneStateStale = c.activeChannels == 1;
+
+    for (int channel = 0; channel < c.activeChannels; ++channel)
+    {
+        if (channel < 2) p.toneFilter[channel].process (c.buffer.getWritePointer(channel), c.numSamples);
+    }
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::widthStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    // With dual-mono content the side signal is zero, so there's nothing to widen.
+    if (c.activeChannels < 2 || c.coefficients.width == 1.0f) return;
+
+    p.kernels->width (c.buffer.getWritePointer (0), c.buffer.getWritePointer (1), c.numSamples, c.coefficients.width);
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::mixStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    for (int channel = 0; channel < c.activeChannels; ++channel)
+    {
+        auto* wet = c.buffer.getWritePointer (channel);
+        if (channel < 2) p.kernels->mixRamp (wet, p.dryBuffer.getReadPointer (p.monoContent ? 0 : channel), c.numSamples, c.mixStart, c.coefficients.mix);
+        else             p.kernels->gainRamp (wet, c.numSamples, c.mixStart, c.coefficients.mix);
+    }
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::outputStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    for (int channel = 0; channel < c.activeChannels; ++channel)
+        p.kernels->gainRamp (c.buffer.getWritePointer (channel), c.numSamples, c.outputGainStart, c.coefficients.outputGain);
+    expandToStereo (c.buffer, c.activeChannels, c.numChannels, c.numSamples);
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::limiterStage (NewLouderSaturator_Feb21AudioProcessor& p, BlockContext& c) noexcept
+{
+    if (! p.limiterEnabled) {
+        p.limiterGain.store (1.0f);
+        return;
+    }
+
+    p.limiter.setCeiling (c.coefficients.limiterCeiling);
+    p.limiter.process (c.buffer.getArrayOfWritePointers(), c.numChannels, c.numSamples);
+    p.limiterGain.store (p.limiter.getMinGain());
+}
 
-        if (tone != 0.0f)
+//==============================================================================
+const char* NewLouderSaturator_Feb21AudioProcessor::getModuleName (Module module) noexcept
+{
+    static const char* const names[] = { "reverb", "drive", "tone", "width" };
+    return names[juce::jlimit (0, (int) Module::numModules - 1, (int) module)];
+}
+
+NewLouderSaturator_Feb21AudioProcessor::ModuleOrder NewLouderSaturator_Feb21AudioProcessor::getModuleOrder() const
+{
+    ModuleOrder order { Module::reverb, Module::drive, Module::tone, Module::width };
+
+    // Stored as e.g. "tone reverb drive width"; anything that isn't a permutation falls back to the default.
+    juce::StringArray tokens;
+    tokens.addTokens (apvts.state.getProperty ("chainOrder").toString(), " ", {});
+
+    if (tokens.size() == (int) Module::numModules)
+    {
+        ModuleOrder parsed {};
+        bool seen[(size_t) Module::numModules] = {};
+        bool valid = true;
+
+        for (int i = 0; i < tokens.size() && valid; ++i)
         {
-            float cutoffFrequency;
-            if (tone < 0.0f) {
-                cutoffFrequency = juce::jmap (tone, -100.0f, 0.0f, 200.0f, 20000.0f); 
-                for (int i = 0; i < 2; ++i) toneFilter[i].setType (juce::dsp::StateVariableTPTFilterType::lowpass);
-            } else {
-                cutoffFrequency = juce::jmap (tone, 0.0f, 100.0f, 20.0f, 2000.0f); 
-                for (int i = 0; i < 2; ++i) toneFilter[i].setType (juce::dsp::StateVariableTPTFilterType::highpass);
+            int index = 0;
+            while (index < (int) Module::numModules && tokens[i] != getModuleName ((Module) index)) ++index;
+
+            valid = index < (int) Module::numModules && ! seen[index];
+            if (valid) {
+                seen[index] = true;
+                parsed[(size_t) i] = (Module) index;
             }
+        }
 
-            for (int i = 0; i < 2; ++i) toneFilter[i].setCutoffFrequency (cutoffFrequency);
+        if (valid) order = parsed;
+    }
 
-            for (int channel = 0; channel < numChannels; ++channel)
-            {
-                if (channel < 2) 
-                {
-                    auto* channelData = buffer.getWritePointer(channel);
-                    for (int sample = 0; sample < numSamples; ++sample)
-                        channelData[sample] = toneFilter[channel].processSample (0, channelData[sample]);
-                }
-            }
+    // The reverb/drive order itself comes from the automatable switch.
+    auto reverbPos = std::find (order.begin(), order.end(), Module::reverb);
+    auto drivePos  = std::find (order.begin(), order.end(), Module::drive);
+    const bool post = apvts.getRawParameterValue ("prePostSwitch")->load() >= 0.5f;
+    if ((reverbPos > drivePos) != post) std::iter_swap (reverbPos, drivePos);
+
+    return order;
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::setModuleOrder (const ModuleOrder& newOrder)
+{
+    juce::StringArray tokens;
+    for (auto module : newOrder) tokens.add (getModuleName (module));
+    apvts.state.setProperty ("chainOrder", tokens.joinIntoString (" "), nullptr);
+
+    const bool post = std::find (newOrder.begin(), newOrder.end(), Module::drive)
+                    < std::find (newOrder.begin(), newOrder.end(), Module::reverb);
+    if (auto* prePostParam = apvts.getParameter ("prePostSwitch"))
+        if ((prePostParam->getValue() >= 0.5f) != post) {
+            prePostParam->beginChangeGesture();
+            prePostParam->setValueNotifyingHost (post ? 1.0f : 0.0f);
+            prePostParam->endChangeGesture();
         }
 
-        if (numChannels > 1 && width != 1.0f) 
+    compileChain();
+}
+
+// Message thread. Turns the module order into flat stage lists, one per prePostSwitch position,
+// and hands them to the audio thread without locking it.
+void NewLouderSaturator_Feb21AudioProcessor::compileChain()
+{
+    auto order = getModuleOrder();
+    auto compiled = std::make_unique<CompiledRouting>();
+
+    for (int post = 0; post < 2; ++post)
+    {
+        auto reverbPos = std::find (order.begin(), order.end(), Module::reverb);
+        auto drivePos  = std::find (order.begin(), order.end(), Module::drive);
+        if ((reverbPos > drivePos) != (post == 1)) std::iter_swap (reverbPos, drivePos);
+
+        auto& chain = compiled->variants[post];
+        auto add = [&chain] (StageFunction fn, [[maybe_unused]] ProfiledStages::Stage id)
         {
-            auto* leftChannel = buffer.getWritePointer (0);
-            auto* rightChannel = buffer.getWritePointer (1);
-            for (int sample = 0; sample < numSamples; ++sample)
+            auto& stage = chain.stages[(size_t) chain.numStages++];
+            stage.process = fn;
+           #if LOUDER_ENABLE_PROFILER
+            stage.profileId = id;
+           #endif
+        };
+
+        add (&gainStage, ProfiledStages::gain);
+        add (&dryTapStage, ProfiledStages::dryTap);
+
+        for (auto module : order)
+        {
+            switch (module)
             {
-                float mid = (leftChannel[sample] + rightChannel[sample]) * 0.5f;
-                float side = (leftChannel[sample] - rightChannel[sample]) * 0.5f;
-                side *= width; 
-                leftChannel[sample] = mid + side;
-                rightChannel[sample] = mid - side;
+                case Module::reverb: add (&reverbStage, ProfiledStages::reverb); break;
+                case Module::drive:  add (&driveStage,  ProfiledStages::drive);  break;
+                case Module::tone:   add (&toneStage,   ProfiledStages::tone);   break;
+                case Module::width:  add (&widthStage,  ProfiledStages::width);  break;
+                case Module::numModules: break;
             }
         }
 
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            buffer.applyGain(channel, 0, numSamples, mix);
-            if (channel < 2) buffer.addFrom(channel, 0, dryBuffer, channel, 0, numSamples, 1.0f - mix);
+        add (&mixStage, ProfiledStages::mix);
+        add (&outputStage, ProfiledStages::output);
+        add (&limiterStage, ProfiledStages::limiter);
+    }
+
+    routing.publish (std::move (compiled));
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::updateMonoDetection (const juce::AudioBuffer<float>& buffer, int numSamples, float peak) noexcept
+{
+    // The oversampler keeps per-channel filter state we can't hand over, so the fast path is
+    // realtime-only (that's also where the saving matters).
+    if (buffer.getNumChannels() != 2 || oversamplers[0] != nullptr) {
+        monoContent = false;
+        matchingBlocks = 0;
+        return;
+    }
+
+    if (channelsMatch (buffer.getReadPointer (0), buffer.getReadPointer (1), numSamples, peak)) {
+        matchingBlocks = juce::jmin (matchingBlocks + 1, monoEntryBlocks);
+        monoContent = matchingBlocks >= monoEntryBlocks;
+    } else {
+        matchingBlocks = 0;
+        monoContent = false;
+    }
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::processDrive (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, Saturation::BlockFunction saturate,
+                                                           float driveStart, float drive, bool dcBlock) noexcept
+{
+    driveJob = { &buffer, numSamples, saturate, driveStart, drive, dcBlock };
+    const int channels = juce::jmin (numChannels, 2);
+
+    if (! dcBlock) {
+        driveDcBlockerActive = false;
+    } else {
+        if (! driveDcBlockerActive) {
+            for (auto& blocker : driveDcBlocker) blocker.reset();
+            driveDcBlockerActive = true;
         }
 
-        buffer.applyGain(outputGain);
-    } 
+        // As with the tone filter, the right blocker's history is the left one's after dual-mono input.
+        if (channels > 1 && rightDcStateStale) driveDcBlocker[1] = driveDcBlocker[0];
+        rightDcStateStale = channels == 1;
+    }
+
+   #if LOUDER_CLAP_EXTENSIONS && LOUDER_CLAP_THREAD_POOL
+    if (channels == 2 && requestDriveOnHostThreads())
+        return;
+   #endif
+
+    for (int channel = 0; channel < channels; ++channel)
+        processDriveChannel (channel);
+}
+
+// The channels share nothing but the read-only driveJob, so they can run on different threads.
+void NewLouderSaturator_Feb21AudioProcessor::processDriveChannel (int channel) noexcept
+{
+    const auto& job = driveJob;
+    float* data = job.buffer->getWritePointer (channel);
 
-    float maxOutput = 0.0f;
-    for (int ch = 0; ch < numChannels; ++ch) {
-        maxOutput = juce::jmax(maxOutput, buffer.getMagnitude(ch, 0, numSamples));
+    auto* oversampler = oversamplers[(size_t) channel].get();
+    if (oversampler == nullptr)
+    {
+        saturateRamped (data, job.numSamples, job.driveStart, job.drive);
     }
-    outputLevel.store(maxOutput);
+    else
+    {
+        // Run the oversampler even at zero drive so the latency we reported stays true.
+        juce::dsp::AudioBlock<float> block (&data, 1, (size_t) job.numSamples);
+        const float driveStep = (job.drive - job.driveStart) / (float) job.numSamples;
+
+        for (int start = 0; start < job.numSamples; start += preparedBlockSize)
+        {
+            const int length = juce::jmin (preparedBlockSize, job.numSamples - start);
+            auto subBlock = block.getSubBlock ((size_t) start, (size_t) length);
+            auto upsampled = oversampler->processSamplesUp (subBlock);
+
+            saturateRamped (upsampled.getChannelPointer (0), (int) upsampled.getNumSamples(),
+                            job.driveStart + driveStep * (float) start, job.driveStart + driveStep * (float) (start + length));
+
+            oversampler->processSamplesDown (subBlock);
+        }
+    }
+
+    if (job.dcBlock) driveDcBlocker[channel].process (data, job.numSamples);
+}
+
+// The saturation kernels take one gain per call, so a drive ramp scales the input first:
+// curve (x * r * g1), with r ramping from g0 / g1 to 1, is curve (x * g) with g ramping from g0 to g1.
+// Zero drive bypasses the curve; a ramp to or from it saturates all the way, at a gain of 1 at that end.
+void NewLouderSaturator_Feb21AudioProcessor::saturateRamped (float* data, int numSamples, float fromDrive, float toDrive) const noexcept
+{
+    if (fromDrive <= 0.0f && toDrive <= 0.0f)
+        return;
+
+    const float endGain = 1.0f + toDrive;
+    if (fromDrive != toDrive)
+        kernels->gainRamp (data, numSamples, (1.0f + fromDrive) / endGain, 1.0f);
+
+    driveJob.saturate (data, numSamples, endGain);
+}
+
+juce::String NewLouderSaturator_Feb21AudioProcessor::getMemoryFootprintReport() const
+{
+    const size_t perInstance = sizeof (*this) + reverb.getHeapBytes() + limiter.getHeapBytes()
+                             + (size_t) dryBuffer.getNumChannels() * (size_t) dryBuffer.getNumSamples() * sizeof (float);
+    // The saturation tables are constexpr data in the binary, so there is one copy per process with
+    // or without the cache. Only the tone tables, one set per rate, are something the cache saves.
+    const size_t binaryTables = sizeof (Saturation::classicTable) + sizeof (Saturation::tubeTable) + sizeof (Saturation::tapeTable);
+    const size_t sharedCache = resourceCache->getLiveBytes();
+
+    juce::String report;
+    report << "LOUDER memory @ " << getSampleRate() << " Hz, block " << getBlockSize() << ":\n"
+           << "  per instance " << (juce::int64) perInstance / 1024 << " KiB (reverb delay lines "
+           << (juce::int64) reverb.getHeapBytes() / 1024 << " KiB)\n"
+           << "  saturation tables " << (juce::int64) binaryTables / 1024 << " KiB (read-only data of the binary)\n"
+           << "  resource cache " << (juce::int64) sharedCache / 1024 << " KiB (tone tables, one set per sample rate)\n";
+
+    for (int instances : { 1, 50, 200 })
+        report << "  " << instances << " instances: " << (juce::int64) (instances * perInstance + binaryTables + sharedCache) / 1024
+               << " KiB, the cache saves " << (juce::int64) ((size_t) (instances - 1) * sizeof (SharedDspResources)) / 1024 << " KiB\n";
+
+    return report;
 }
 
 bool NewLouderSaturator_Feb21AudioProcessor::hasEditor() const { return true; }
@@ -265,10 +1016,120 @@ void NewLouderSaturator_Feb21AudioProcessor::setStateInformation (const void* da
 {
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState.get() != nullptr)
-        if (xmlState->hasTagName (apvts.state.getType()))
+        if (xmlState->hasTagName (apvts.state.getType())) {
             apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+            compileChain();
+        }
+}
+
+#if LOUDER_CLAP_EXTENSIONS
+//==============================================================================
+// Audio thread. Does what the JUCE wrappers do around processBlock (in-place buffers, the callback
+// lock, suspension), but cuts the block at every parameter event so each sub-block starts from the
+// values the host asked for at that sample.
+clap_process_status NewLouderSaturator_Feb21AudioProcessor::clap_direct_process (const clap_process* process) noexcept
+{
+    const auto* events = process->in_events;
+    const auto numEvents = events->size (events);
+
+    if (process->audio_outputs_count == 0 || process->audio_outputs[0].data32 == nullptr)
+    {
+        for (uint32_t e = 0; e < numEvents; ++e) applyClapEvent (events->get (events, e));
+        return CLAP_PROCESS_CONTINUE;
+    }
+
+    const auto& output = process->audio_outputs[0];
+    const int numChannels = (int) output.channel_count;
+    const int numSamples = (int) process->frames_count;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* out = output.data32[ch];
+        const bool hasInput = process->audio_inputs_count > 0 && ch < (int) process->audio_inputs[0].channel_count;
+
+        if (! hasInput)                                         juce::FloatVectorOperations::clear (out, numSamples);
+        else if (process->audio_inputs[0].data32[ch] != out)  juce::FloatVectorOperations::copy (out, process->audio_inputs[0].data32[ch], numSamples);
+    }
+
+    const juce::ScopedLock lock (getCallbackLock());
+
+    if (isSuspended())
+    {
+        for (uint32_t e = 0; e < numEvents; ++e) applyClapEvent (events->get (events, e));
+        for (int ch = 0; ch < numChannels; ++ch) juce::FloatVectorOperations::clear (output.data32[ch], numSamples);
+        return CLAP_PROCESS_CONTINUE;
+    }
+
+    followParametersInline = true;
+
+    uint32_t next = 0;
+    for (int start = 0; start < numSamples;)
+    {
+        // Apply everything due by 'start', then run up to the next event.
+        int end = numSamples;
+        for (; next < numEvents; ++next)
+        {
+            const auto* header = events->get (events, next);
+            if ((int) header->time > start) {
+                end = juce::jmin (end, (int) header->time);
+                break;
+            }
+            applyClapEvent (header);
+        }
+
+        juce::AudioBuffer<float> block (output.data32, numChannels, start, end - start);
+        processBlock (block, clapMidi);
+        start = end;
+    }
+
+    for (; next < numEvents; ++next) applyClapEvent (events->get (events, next));
+
+    followParametersInline = false;
+    return CLAP_PROCESS_CONTINUE;
+}
+
+// Parameters arrive normalised, as clap-juce-extensions publishes them. Notifying the listeners is
+// what moves the tree state's value and the coefficient generation, as host automation does in the
+// JUCE wrappers.
+void NewLouderSaturator_Feb21AudioProcessor::applyClapEvent (const clap_event_header* header) noexcept
+{
+    if (header->space_id != CLAP_CORE_EVENT_SPACE_ID || header->type != CLAP_EVENT_PARAM_VALUE)
+        return;
+
+    const auto* event = reinterpret_cast<const clap_event_param_value*> (header);
+    for (const auto& entry : clapParameters)
+    {
+        if (entry.id != event->param_id)
+            continue;
+
+        const auto value = (float) juce::jlimit (0.0, 1.0, event->value);
+        entry.parameter->setValue (value);
+        entry.parameter->sendValueChangedMessageToListeners (value);
+        return;
+    }
 }
 
+#if LOUDER_CLAP_THREAD_POOL
+// The host only runs pool tasks from inside its process call, so this is limited to direct process.
+// Only oversampled drive is worth a task per channel, and only the offline profiles oversample, so in
+// practice this runs during offline renders only. requestThreadPoolExec() returns false if the host
+// has no thread pool or turns the request down, and then both channels run here as usual.
+bool NewLouderSaturator_Feb21AudioProcessor::requestDriveOnHostThreads() noexcept
+{
+    if (! followParametersInline || oversamplers[0] == nullptr || driveJob.numSamples < minThreadPoolSamples)
+        return false;
+
+    return requestThreadPoolExec (2);
+}
+
+void NewLouderSaturator_Feb21AudioProcessor::threadPoolExec (uint32_t taskIndex) noexcept
+{
+    if (taskIndex < 2)
+        processDriveChannel ((int) taskIndex);
+}
+#endif
+#endif
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new NewLouderSaturator_Feb21AudioProcessor();
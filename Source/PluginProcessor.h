@@ -1,8 +1,42 @@
 #pragma once
 #include <JuceHeader.h>
 #include <juce_dsp/juce_dsp.h>
+#include "SaturationCurves.h"
+#include "StageProfiler.h"
+#include "CallbackMonitor.h"
+#include "CpuGovernor.h"
+#include "DspKernels.h"
+#include "HalfBandResampler.h"
+#include "LookaheadLimiter.h"
+#include "RcuSlot.h"
+#include "RoomReverb.h"
+#include "SaturationCurves.h"
+#include "SharedResources.h"
+#include "ToneFilter.h"
+#include <mutex>
 
-class NewLouderSaturator_Feb21AudioProcessor  : public juce::AudioProcessor
+// Set by the CMake build when it links clap-juce-extensions (see Docs/Clap.md). The processor then
+// takes the CLAP process call directly and can hand the drive stage to the host's thread pool. The
+// other formats built from the same code ignore both.
+#ifndef LOUDER_CLAP_EXTENSIONS
+ #define LOUDER_CLAP_EXTENSIONS 0
+#endif
+
+#ifndef LOUDER_CLAP_THREAD_POOL
+ #define LOUDER_CLAP_THREAD_POOL LOUDER_CLAP_EXTENSIONS
+#endif
+
+#if LOUDER_CLAP_EXTENSIONS
+ #include <clap-juce-extensions/clap-juce-extensions.h>
+#endif
+
+class NewLouderSaturator_Feb21AudioProcessor  : public juce::AudioProcessor,
+                                               #if LOUDER_CLAP_EXTENSIONS
+                                                public clap_juce_extensions::clap_properties,
+                                                public clap_juce_extensions::clap_juce_audio_processor_capabilities,
+                                               #endif
+                                                private juce::AudioProcessorValueTreeState::Listener,
+                                                private ParameterPoller::Client
 {
 public:
     NewLouderSaturator_Feb21AudioProcessor();
@@ -20,6 +54,7 @@ public:
     bool producesMidi() const override;
     bool isMidiEffect() const override;
     double getTailLengthSeconds() const override;
+    juce::AudioProcessorParameter* getBypassParameter() const override;
     int getNumPrograms() override;
     int getCurrentProgram() override;
     void setCurrentProgram (int index) override;
@@ -28,19 +63,253 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+   #if LOUDER_CLAP_EXTENSIONS
+    // Splits each CLAP block at its parameter events, so automation lands on the exact sample.
+    bool supportsDirectProcess() override { return true; }
+    clap_process_status clap_direct_process (const clap_process* process) noexcept override;
+
+   #if LOUDER_CLAP_THREAD_POOL
+    // clap.thread-pool: task 0 and 1 are the left and right drive channels.
+    bool supportsThreadPool() const noexcept override { return true; }
+    void threadPoolExec (uint32_t taskIndex) noexcept override;
+   #endif
+   #endif
+
     juce::AudioProcessorValueTreeState apvts;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
     std::atomic<float> inputLevel { 0.0f };
     std::atomic<float> outputLevel { 0.0f };
 
+    // CPU governor state for the editor: the tier the chain runs at (0 = full quality) and the 95th
+    // percentile block time as a fraction of the deadline. Both stay at 0 while the governor is off.
+    std::atomic<int> governorTier { 0 };
+    std::atomic<float> governorLoad { 0.0f };
+
+    // Lowest gain the limiter applied in the last block (1 = no reduction), for the output meter.
+    std::atomic<float> limiterGain { 1.0f };
+
+    // The reorderable part of the chain. Input gain and the dry tap always come first, mix and
+    // output always last. Reverb/drive order is owned by the "prePostSwitch" parameter so it stays
+    // automatable; getModuleOrder() reports it and setModuleOrder() writes it back.
+    enum class Module { reverb = 0, drive, tone, width, numModules };
+    using ModuleOrder = std::array<Module, (size_t) Module::numModules>;
+
+    static const char* getModuleName (Module module) noexcept;
+    ModuleOrder getModuleOrder() const;
+    void setModuleOrder (const ModuleOrder& newOrder);
+
+    // Estimated resident memory for 1/50/200 instances at the current sample rate and block size.
+    juce::String getMemoryFootprintReport() const;
+
+    // Times each processBlock against its deadline. Only enabled in the standalone app (and by
+    // LouderBatchRender --diagnose-callback); see StandaloneDiagnostics.h for the readout.
+    CallbackMonitor callbackMonitor;
+
+   #if LOUDER_ENABLE_PROFILER
+    StageProfiler profiler;
+   #endif
+
 private:
-    juce::Reverb reverb;
-    juce::Reverb::Parameters reverbParameters;
-    juce::dsp::StateVariableTPTFilter<float> toneFilter[2];
+    // Everything derived from the parameters, computed off the audio thread whenever one of them
+    // changes (see updateCoefficients()). Arrays indexed by isNonRealtime() hold both quality
+    // profiles, so a realtime/offline flip doesn't need a new set.
+    struct CoefficientSet
+    {
+        juce::uint32 generation = 0;
+        RoomReverb::Coefficients reverb;
+        Saturation::BlockFunction saturate[2] {};
+        bool dcBlock = false;
+        int reverbDensity[2] {};
+        float inputGain = 1.0f, drive = 0.0f, width = 1.0f, mix = 1.0f, outputGain = 1.0f;
+        bool toneActive = false;
+        ToneFilter::Type toneType = ToneFilter::Type::lowpass;
+        float toneCoefficient = 0.0f;
+        bool decimateReverb = false;
+        bool governorEnabled = false;
+        float limiterCeiling = 1.0f;
+        int chainVariant = 0;
+    };
+
+    // Everything a stage needs for one block, gathered before the chain runs. The gains and the
+    // drive ramp from the previous block's values when a new coefficient set has arrived.
+    struct BlockContext
+    {
+        juce::AudioBuffer<float>& buffer;
+        int numSamples, numChannels, activeChannels;
+        const CoefficientSet& coefficients;
+        Saturation::BlockFunction saturate;
+        bool coefficientsChanged;
+        float inputGainStart, driveStart, mixStart, outputGainStart, reverbDryStart;
+    };
+
+    using StageFunction = void (*) (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+
+    struct CompiledStage
+    {
+        StageFunction process;
+       #if LOUDER_ENABLE_PROFILER
+        ProfiledStages::Stage profileId;
+       #endif
+    };
+
+    struct CompiledChain
+    {
+        std::array<CompiledStage, (size_t) Module::numModules + 5> stages {};
+        int numStages = 0;
+    };
+
+    // Both reverb/drive variants are compiled up front, indexed by the "prePostSwitch" value, so
+    // automating that parameter never needs a recompile.
+    struct CompiledRouting
+    {
+        CompiledChain variants[2];
+    };
+
+    void compileChain();
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void pollParameters() override;
+    void computeCoefficients (CoefficientSet& set) const noexcept;
+    void updateCoefficients (bool force);
+    RoomReverb::Storage getSelectedReverbStorage() const;
+    bool isLimiterSelected() const;
+    void updateLatency();
+
+    static void gainStage   (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void dryTapStage (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void reverbStage (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void driveStage  (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void toneStage   (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void widthStage  (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void mixStage    (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void outputStage (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+    static void limiterStage (NewLouderSaturator_Feb21AudioProcessor&, BlockContext&) noexcept;
+
+    void processDrive (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, Saturation::BlockFunction saturate,
+                       float driveStart, float drive, bool dcBlock) noexcept;
+    void processDriveChannel (int channel) noexcept;
+    void saturateRamped (float* data, int numSamples, float fromDrive, float toDrive) const noexcept;
+   #if LOUDER_CLAP_EXTENSIONS
+    void applyClapEvent (const clap_event_header* header) noexcept;
+   #if LOUDER_CLAP_THREAD_POOL
+    bool requestDriveOnHostThreads() noexcept;
+   #endif
+   #endif
+    RoomReverb::Parameters computeReverbParameters() const;
+    void flushProcessingState() noexcept;
+    void setReverbDecimation (bool enabled) noexcept;
+    void processReverbDecimated (juce::AudioBuffer<float>& buffer, int numSamples, float dryStart, float dryGain) noexcept;
+    void updateMonoDetection (const juce::AudioBuffer<float>& buffer, int numSamples, float peak) noexcept;
+
+    RoomReverb reverb;
+    ToneFilter toneFilter[2];
     
     // ---> THE FIX: Pre-allocated memory for our dry signal <---
     juce::AudioBuffer<float> dryBuffer; 
 
+    // Oversampling is chosen once in prepareToPlay so the reported latency never changes mid-render;
+    // the dry path is delayed by the same amount to stay phase-aligned in the mix. One oversampler
+    // per channel, so the two sides of the drive stage can run on different threads.
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2> oversamplers;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> dryDelay;
+    int oversamplingLatency = 0;
+
+    // Strips the offset the asymmetric tube curve adds, at the session rate after downsampling.
+    // Started from zero whenever the model switches to one that needs it.
+    Saturation::DcBlocker driveDcBlocker[2];
+    bool driveDcBlockerActive = false;
+
+    // What processDriveChannel() works on for the current block.
+    struct DriveJob
+    {
+        juce::AudioBuffer<float>* buffer = nullptr;
+        int numSamples = 0;
+        Saturation::BlockFunction saturate = nullptr;
+        float driveStart = 0.0f, drive = 0.0f;
+        bool dcBlock = false;
+    };
+
+    DriveJob driveJob;
+
+    // The last stage. Its lookahead adds to the reported latency (latencySamples is the total, which
+    // the bypass path is delayed by), so it's switched like a setup option: on the message thread,
+    // with processing suspended, never by automation.
+    LookaheadLimiter limiter;
+    bool limiterEnabled = false;
+    int latencySamples = 0;
+    int preparedBlockSize = 0;
+    double preparedSampleRate = 44100.0;
+
+    // At 88.2 kHz and up the reverb can run its wet path at 1/2 or 1/4 of the session rate, back
+    // near 44.1/48 kHz where the damped tail has all its content anyway. The dry path stays at the
+    // session rate. Its delay memory is sized for the full rate, so switching never allocates.
+    HalfBandResampler reverbResampler;
+    juce::AudioBuffer<float> reverbScratch;
+    int reverbDecimationStages = 0;
+
+    // Bypass crossfades over 20 ms against the input, delayed by the reported latency. Once the ramp
+    // (and, with "Ring Out", the tail) is finished the chain is flushed and stops running entirely.
+    juce::LinearSmoothedValue<float> bypassMix { 1.0f };
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> bypassDelay;
+    juce::AudioBuffer<float> bypassBuffer;
+    std::vector<float> bypassRamp;
+    bool wasBypassed = false, tailRinging = false, chainIdle = false;
+    int silentTailBlocks = 0;
+
+    // Per-sample loops built for the widest instruction set this CPU has, chosen in prepareToPlay.
+    const Kernels::Table* kernels = &Kernels::getTable (Kernels::Isa::generic);
+
+    // Read-only tables shared with every other instance at this sample rate. Fetched in
+    // prepareToPlay (which may lock); the audio thread only dereferences our own reference.
+    juce::SharedResourcePointer<SharedResourceCache> resourceCache;
+    std::shared_ptr<const SharedDspResources> resources;
+
+    // Dual-mono detection: after enough matching blocks the drive/tone/mix stages run on the left
+    // channel only and the result is copied to the right. Any mismatch drops back to stereo at once.
+    bool monoContent = false;
+    int matchingBlocks = 0, monoEntryBlocks = 1;
+    bool rightToneStateStale = false, rightDcStateStale = false;
+
+    // Compiled on the message thread, picked up by processBlock at the start of the next block.
+    RcuSlot<CompiledRouting> routing;
+
+    // Parameter listeners only bump the generation (they can fire on the audio thread during
+    // automation). The process-wide poller calls pollParameters() on the message thread, which
+    // recomputes and publishes a new set when the generation has moved on since its last look.
+    // Offline renders recompute in place on the audio thread instead, so every block sees its
+    // automation. coefficientLock orders the message thread against prepareToPlay, which swaps
+    // resources and publishes too.
+    RcuSlot<CoefficientSet> coefficients;
+    CoefficientSet offlineCoefficients;
+    std::atomic<juce::uint32> parameterGeneration { 1 };
+    juce::uint32 publishedGeneration = 0, appliedGeneration = 0, polledGeneration = 0;
+    float appliedInputGain = 1.0f, appliedDrive = 0.0f, appliedMix = 1.0f, appliedOutputGain = 1.0f, appliedReverbDry = 1.0f;
+    std::mutex coefficientLock;
+    juce::SharedResourcePointer<ParameterPoller> parameterPoller;
+
+    // Realtime only: each tier drops one reverb comb group (faded by RoomReverb), down to one.
+    CpuGovernor governor;
+    bool governorActive = false;
+
+    // Set while clap_direct_process() runs: processBlock() then recomputes the coefficients in place
+    // for every sub-block instead of waiting for the message thread, as offline renders do.
+    bool followParametersInline = false;
+
+   #if LOUDER_CLAP_EXTENSIONS
+    // CLAP ids are the hash of the JUCE parameter id, as clap-juce-extensions assigns them.
+    struct ClapParameter
+    {
+        clap_id id;
+        juce::AudioProcessorParameter* parameter;
+    };
+
+    std::vector<ClapParameter> clapParameters;
+    juce::MidiBuffer clapMidi;
+
+    // Below this block length the host's wakeup costs more than running the right channel here.
+    static constexpr int minThreadPoolSamples = 128;
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NewLouderSaturator_Feb21AudioProcessor)
 };
\ No newline at end of file
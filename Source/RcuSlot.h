@@ -0,0 +1,79 @@
+#pragma once
+#include <JuceHeader.h>
+#include <mutex>
+
+// Read-copy-update hand-off of immutable objects from non-realtime threads to the audio thread.
+//
+// Writers build a complete new object and publish() it. The audio thread calls acquire() once per
+// block and keeps using whatever it got until the next block; it never allocates, frees or locks.
+// Objects it has finished with go onto a small lock-free retire queue and are deleted by the next
+// writer (or the destructor), never on the audio thread.
+template <typename ObjectType>
+class RcuSlot
+{
+public:
+    RcuSlot() = default;
+
+    ~RcuSlot()
+    {
+        delete pending.exchange (nullptr);
+        delete current;
+        collectGarbage();
+    }
+
+    // Any non-realtime thread. Replaces a pending object the audio thread hasn't picked up yet.
+    void publish (std::unique_ptr<ObjectType> next)
+    {
+        const std::lock_guard<std::mutex> lock (writerLock);
+        collectGarbageLocked();
+        delete pending.exchange (next.release(), std::memory_order_acq_rel);
+    }
+
+    // Any non-realtime thread.
+    void collectGarbage()
+    {
+        const std::lock_guard<std::mutex> lock (writerLock);
+        collectGarbageLocked();
+    }
+
+    // Audio thread only (or while the audio thread is known to be stopped, e.g. prepareToPlay).
+    // If the retire queue is full the swap is simply deferred to a later block.
+    const ObjectType* acquire() noexcept
+    {
+        if (pending.load (std::memory_order_acquire) != nullptr && retired.getFreeSpace() > 0)
+        {
+            if (auto* next = pending.exchange (nullptr, std::memory_order_acq_rel))
+            {
+                if (current != nullptr) {
+                    const auto scope = retired.write (1);
+                    retiredObjects[(size_t) scope.startIndex1] = current;
+                }
+                current = next;
+            }
+        }
+
+        return current;
+    }
+
+    // Audio thread only: the object returned by the last acquire().
+    const ObjectType* get() const noexcept { return current; }
+
+private:
+    void collectGarbageLocked()
+    {
+        const auto scope = retired.read (retired.getNumReady());
+        for (int i = 0; i < scope.blockSize1; ++i) delete retiredObjects[(size_t) (scope.startIndex1 + i)];
+        for (int i = 0; i < scope.blockSize2; ++i) delete retiredObjects[(size_t) (scope.startIndex2 + i)];
+    }
+
+    static constexpr int retireCapacity = 16;
+
+    std::atomic<ObjectType*> pending { nullptr };
+    ObjectType* current = nullptr;
+
+    juce::AbstractFifo retired { retireCapacity };
+    std::array<ObjectType*, (size_t) retireCapacity> retiredObjects {};
+    std::mutex writerLock;
+
+    JUCE_DECLARE_NON_COPYABLE (RcuSlot)
+};
@@ -0,0 +1,652 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+// Half-precision conversion hardware: F16C is picked at runtime on x86 (every AVX2 CPU has it, but
+// the plugin isn't built for AVX2), NEON always has it on 64-bit ARM.
+#if LOUDER_KERNELS_X86
+ #define LOUDER_REVERB_F16C 1
+#elif LOUDER_KERNELS_NEON
+ #define LOUDER_REVERB_NEON_F16 1
+#endif
+
+// Freeverb-style stereo reverb. At the default density it is the same network and gain staging as
+// juce::Reverb (8 combs + 4 allpasses per side), but the combs are split into groups of four that
+// can be faded in or out, so quality profiles can trade echo density for CPU without a click.
+class RoomReverb
+{
+public:
+    using Parameters = juce::Reverb::Parameters;
+
+    static constexpr int combsPerGroup = 4;
+    static constexpr int maxGroups = 3;
+    static constexpr int defaultGroups = 2;
+
+    // What the delay lines hold. float16 halves the reverb's memory (and the cache traffic of every
+    // comb read); see Docs/ReverbStorage.md for why the difference stays far below the tail.
+    enum class Storage { float32 = 0, float16 };
+
+    RoomReverb()
+    {
+        setParameters (Parameters());
+        setSampleRate (44100.0);
+    }
+
+    // Everything setParameters() derives from the user-facing parameters, so it can be worked out
+    // away from the audio thread and applied later with setCoefficients().
+    struct Coefficients
+    {
+        float dryGain = 0.0f, wetGain1 = 0.0f, wetGain2 = 0.0f;
+        float inputGain = 0.0f, damping = 0.0f, feedback = 0.0f;
+    };
+
+    static Coefficients computeCoefficients (const Parameters& newParams) noexcept
+    {
+        const float wetScaleFactor = 3.0f;
+        const float dryScaleFactor = 2.0f;
+        const bool frozen = newParams.freezeMode >= 0.5f;
+
+        const float wet = newParams.wetLevel * wetScaleFactor;
+        Coefficients c;
+        c.dryGain = newParams.dryLevel * dryScaleFactor;
+        c.wetGain1 = 0.5f * wet * (1.0f + newParams.width);
+        c.wetGain2 = 0.5f * wet * (1.0f - newParams.width);
+        c.inputGain = frozen ? 0.0f : 0.015f;
+        c.damping = frozen ? 0.0f : newParams.damping * 0.4f;
+        c.feedback = frozen ? 1.0f : newParams.roomSize * 0.28f + 0.7f;
+        return c;
+    }
+
+    void setCoefficients (const Coefficients& c) noexcept
+    {
+        dryGain.setTargetValue (c.dryGain);
+        wetGain1.setTargetValue (c.wetGain1);
+        wetGain2.setTargetValue (c.wetGain2);
+        gain = c.inputGain;
+        damping.setTargetValue (c.damping);
+        feedback.setTargetValue (c.feedback);
+    }
+
+    void setParameters (const Parameters& newParams) noexcept
+    {
+        setCoefficients (computeCoefficients (newParams));
+    }
+
+    // Only the first groupsToAllocate comb groups get delay memory; setDensity() can't go above that.
+    void setSampleRate (double sampleRate, int groupsToAllocate = defaultGroups, Storage newStorage = Storage::float32)
+    {
+        allocatedGroups = juce::jlimit (1, maxGroups, groupsToAllocate);
+        numGroups = juce::jmin (numGroups, allocatedGroups);
+        allocatedRate = sampleRate;
+        storage = newStorage;
+
+        const int bytesPerSample = getBytesPerSample();
+        forEachDelayLength (sampleRate, [bytesPerSample] (DelayLine& line, int length) { line.setSize (length, bytesPerSample); });
+        setProcessingRate (sampleRate);
+    }
+
+    // Reallocates the delay lines in the new format, keeping the rate and density. Clears the tail.
+    void setStorage (Storage newStorage)
+    {
+        if (newStorage == storage)
+            return;
+
+        const double rate = processingRate;
+        setSampleRate (allocatedRate, allocatedGroups, newStorage);
+        setProcessingRate (rate);
+    }
+
+    Storage getStorage() const noexcept { return storage; }
+
+    // Re-tunes the network for a lower internal rate (decimated processing) inside the memory that
+    // setSampleRate() allocated. Clears the tail but never allocates, so it's audio-thread safe.
+    void setProcessingRate (double sampleRate) noexcept
+    {
+        sampleRate = juce::jmin (sampleRate, allocatedRate);
+        processingRate = sampleRate;
+        // Float16 windows can't be longer than the shortest line in use.
+        windowLength = DelayLine::windowCapacity;
+        forEachDelayLength (sampleRate, [this] (DelayLine& line, int length) {
+            line.setLength (length);
+            if (line.getLength() > 0)
+                windowLength = juce::jmin (windowLength, line.getLength());
+        });
+
+        for (auto& channel : comb)
+            for (auto& c : channel)
+                c.last = 0.0f;
+
+        const double smoothTime = 0.01;
+        damping .reset (sampleRate, smoothTime);
+        feedback.reset (sampleRate, smoothTime);
+        dryGain .reset (sampleRate, smoothTime);
+        wetGain1.reset (sampleRate, smoothTime);
+        wetGain2.reset (sampleRate, smoothTime);
+
+        for (int g = 0; g < maxGroups; ++g) {
+            groupGains[g].reset (sampleRate, 0.05);
+            groupGains[g].setCurrentAndTargetValue (g < numGroups ? 1.0f : 0.0f);
+        }
+    }
+
+    void reset()
+    {
+        for (int j = 0; j < numChannels; ++j) {
+            for (auto& c : comb[j])    c.clear();
+            for (auto& a : allPass[j]) a.clear();
+        }
+    }
+
+    // Number of active comb groups (1 up to the allocated count). Groups being removed fade out
+    // before they stop being processed; groups being added start from silence and fade in.
+    void setDensity (int newNumGroups) noexcept
+    {
+        newNumGroups = juce::jlimit (1, allocatedGroups, newNumGroups);
+        if (newNumGroups == numGroups)
+            return;
+
+        for (int g = 1; g < maxGroups; ++g)
+        {
+            const bool wanted = g < newNumGroups;
+            if (wanted && groupGains[g].getCurrentValue() == 0.0f)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int j = g * combsPerGroup; j < (g + 1) * combsPerGroup; ++j)
+                        comb[ch][j].clear();
+
+            groupGains[g].setTargetValue (wanted ? 1.0f : 0.0f);
+        }
+
+        numGroups = newNumGroups;
+    }
+
+    int getDensity() const noexcept { return numGroups; }
+
+    // How long the slowest comb loop takes to fall by the given amount. The damping lowpass has
+    // unity gain at DC, so the feedback coefficient alone sets the decay rate.
+    static double getDecayTimeSeconds (const Parameters& params, double decibels)
+    {
+        if (params.freezeMode >= 0.5f)
+            return std::numeric_limits<double>::infinity();
+
+        const double loopGain = params.roomSize * 0.28 + 0.7;
+        const double longestLoopSeconds = (combTunings[maxGroups * combsPerGroup - 1] + stereoSpread) / 44100.0;
+        return decibels / (-20.0 * std::log10 (loopGain)) * longestLoopSeconds;
+    }
+
+    size_t getHeapBytes() const noexcept
+    {
+        size_t total = 0;
+        for (int j = 0; j < numChannels; ++j) {
+            for (auto& c : comb[j])    total += c.getHeapBytes();
+            for (auto& a : allPass[j]) total += a.getHeapBytes();
+        }
+        return total;
+    }
+
+    // True once the wet gains have settled at zero, i.e. the output is just the scaled dry input.
+    bool isWetSilent() const noexcept
+    {
+        return wetGain1.getTargetValue() == 0.0f && wetGain2.getTargetValue() == 0.0f
+            && ! wetGain1.isSmoothing() && ! wetGain2.isSmoothing();
+    }
+
+    // The storage format is picked once per block, so the sample loops never branch on it.
+    void processStereo (float* const left, float* const right, const int numSamples) noexcept
+    {
+        if (storage == Storage::float16) process<true, Float16> (left, right, numSamples);
+        else                             process<true, Float32> (left, right, numSamples);
+    }
+
+    // Wet signal alone, for running the tail at a decimated rate while the dry path stays at the
+    // session rate. On entry 'left' holds the L+R sum (all the combs ever see of the input); on exit
+    // left/right hold the stereo wet output.
+    void processStereoWet (float* const left, float* const right, const int numSamples) noexcept
+    {
+        if (storage == Storage::float16) process<false, Float16> (left, right, numSamples);
+        else                             process<false, Float32> (left, right, numSamples);
+    }
+
+    void processMono (float* const samples, const int numSamples) noexcept
+    {
+        if (storage == Storage::float16) processMono<Float16> (samples, numSamples);
+        else                             processMono<Float32> (samples, numSamples);
+    }
+
+    //==============================================================================
+    // Delay line sample formats. Float32 is read and written in place, one sample per tick.
+    struct Float32
+    {
+        using Type = float;
+        static constexpr bool windowed = false;
+    };
+
+    // IEEE half precision holding the value times 2^8. The power-of-two scale is exact and moves
+    // the 11-bit mantissa's normal range down to 2.4e-7 (about -132 dB), far below any tail worth
+    // hearing; the clamp keeps a frozen or overdriven loop from storing inf.
+    //
+    // Converting per sample would put a conversion on every comb read and write, so float16 lines
+    // are processed through short float windows instead: each window is converted in bulk (four
+    // lanes at a time with F16C or NEON) before the sample loop and back after it.
+    struct Float16
+    {
+        using Type = std::uint16_t;
+        static constexpr bool windowed = true;
+
+        static constexpr float scale = 256.0f;
+        static constexpr float maxValue = 65504.0f / scale;
+
+        static void toFloat (const std::uint16_t* source, float* dest, int numSamples) noexcept
+        {
+            int i = 0;
+           #if LOUDER_REVERB_F16C
+            if (hasF16C())
+                i = toFloatF16C (source, dest, numSamples);
+           #elif LOUDER_REVERB_NEON_F16
+            for (; i + 4 <= numSamples; i += 4)
+                vst1q_f32 (dest + i, vmulq_n_f32 (vcvt_f32_f16 (vreinterpret_f16_u16 (vld1_u16 (source + i))), 1.0f / scale));
+           #endif
+            for (; i < numSamples; ++i)
+                dest[i] = halfToFloat (source[i]) * (1.0f / scale);
+        }
+
+        static void fromFloat (const float* source, std::uint16_t* dest, int numSamples) noexcept
+        {
+            int i = 0;
+           #if LOUDER_REVERB_F16C
+            if (hasF16C())
+                i = fromFloatF16C (source, dest, numSamples);
+           #elif LOUDER_REVERB_NEON_F16
+            for (; i + 4 <= numSamples; i += 4) {
+                const auto v = vmulq_n_f32 (vminq_f32 (vmaxq_f32 (vld1q_f32 (source + i), vdupq_n_f32 (-maxValue)), vdupq_n_f32 (maxValue)), scale);
+                vst1_u16 (dest + i, vreinterpret_u16_f16 (vcvt_f16_f32 (v)));
+            }
+           #endif
+            for (; i < numSamples; ++i)
+                dest[i] = floatToHalf (juce::jlimit (-maxValue, maxValue, source[i]) * scale);
+        }
+
+       #if LOUDER_REVERB_F16C
+        static bool hasF16C() noexcept { return Kernels::cpuHasF16C(); }
+
+        // Both return how many samples they converted (whole groups of four).
+        LOUDER_TARGET_F16C static int toFloatF16C (const std::uint16_t* source, float* dest, int numSamples) noexcept
+        {
+            const auto gain = _mm_set1_ps (1.0f / scale);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (dest + i, _mm_mul_ps (_mm_cvtph_ps (_mm_loadl_epi64 (reinterpret_cast<const __m128i*> (source + i))), gain));
+            return i;
+        }
+
+        LOUDER_TARGET_F16C static int fromFloatF16C (const float* source, std::uint16_t* dest, int numSamples) noexcept
+        {
+            const auto gain = _mm_set1_ps (scale), lo = _mm_set1_ps (-maxValue), hi = _mm_set1_ps (maxValue);
+            int i = 0;
+            for (; i + 4 <= numSamples; i += 4) {
+                const auto v = _mm_mul_ps (_mm_min_ps (_mm_max_ps (_mm_loadu_ps (source + i), lo), hi), gain);
+                _mm_storel_epi64 (reinterpret_cast<__m128i*> (dest + i), _mm_cvtps_ph (v, _MM_FROUND_TO_NEAREST_INT));
+            }
+            return i;
+        }
+       #endif
+
+        // Portable conversions after Fabian Giesen's, rounding to nearest even. Inputs are already
+        // clamped to the finite half range, so there's no inf/NaN handling.
+        static float halfToFloat (std::uint16_t h) noexcept
+        {
+            std::uint32_t bits = (std::uint32_t) (h & 0x7fffu) << 13;
+            const std::uint32_t exponent = bits & (0x7c00u << 13);
+            bits += (127u - 15u) << 23;
+
+            float result;
+            if (exponent == 0) {                 // zero or subnormal: renormalise through a float subtract
+                bits += 1u << 23;
+                std::memcpy (&result, &bits, sizeof (result));
+                result -= 6.103515625e-05f;      // 2^-14
+            } else {
+                std::memcpy (&result, &bits, sizeof (result));
+            }
+
+            return (h & 0x8000u) != 0 ? -result : result;
+        }
+
+        static std::uint16_t floatToHalf (float value) noexcept
+        {
+            std::uint32_t bits;
+            std::memcpy (&bits, &value, sizeof (bits));
+            const auto sign = (std::uint16_t) ((bits >> 16) & 0x8000u);
+            bits &= 0x7fffffffu;
+
+            std::uint16_t result;
+            if (bits < (113u << 23)) {           // below 2^-14: half subnormal, rounded by a float add
+                float magnitude;
+                std::memcpy (&magnitude, &bits, sizeof (magnitude));
+                magnitude += 0.5f;
+                std::memcpy (&bits, &magnitude, sizeof (bits));
+                result = (std::uint16_t) (bits - 0x3f000000u);
+            } else {
+                const std::uint32_t mantissaOdd = (bits >> 13) & 1u;
+                bits += ((std::uint32_t) (15 - 127) << 23) + 0xfffu + mantissaOdd;
+                result = (std::uint16_t) (bits >> 13);
+            }
+
+            return (std::uint16_t) (result | sign);
+        }
+    };
+
+private:
+    template <typename Format>
+    void processMono (float* const samples, const int numSamples) noexcept
+    {
+        const int groupsToRun = getNumGroupsToRun();
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int end = start + (Format::windowed ? juce::jmin (numSamples - start, windowLength) : numSamples - start);
+            if constexpr (Format::windowed)
+                forEachActiveLine (groupsToRun, 1, [n = end - start] (DelayLine& line) { line.beginWindow (n); });
+
+            for (int i = start; i < end; ++i)
+            {
+                const float input = samples[i] * gain;
+                const float damp = damping.getNextValue();
+                const float feedbck = feedback.getNextValue();
+
+                float output = 0, totalGroupGain = 0;
+                for (int g = 0; g < groupsToRun; ++g)
+                {
+                    const float groupGain = groupGains[g].getNextValue();
+                    float sum = 0;
+                    for (int j = g * combsPerGroup; j < (g + 1) * combsPerGroup; ++j)
+                        sum += comb[0][j].template process<Format> (input, damp, feedbck);
+                    output += sum * groupGain;
+                    totalGroupGain += groupGain;
+                }
+
+                output *= std::sqrt ((float) defaultGroups / totalGroupGain);
+
+                for (int j = 0; j < numAllPasses; ++j)
+                    output = allPass[0][j].template process<Format> (output);
+
+                const float dry = dryGain.getNextValue();
+                const float wet1 = wetGain1.getNextValue();
+
+                samples[i] = output * wet1 + samples[i] * dry;
+            }
+
+            if constexpr (Format::windowed)
+                forEachActiveLine (groupsToRun, 1, [n = end - start] (DelayLine& line) { line.endWindow (n); });
+
+            start = end;
+        }
+    }
+
+    template <bool withDry, typename Format>
+    void process (float* const left, float* const right, const int numSamples) noexcept
+    {
+        const int groupsToRun = getNumGroupsToRun();
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int end = start + (Format::windowed ? juce::jmin (numSamples - start, windowLength) : numSamples - start);
+            if constexpr (Format::windowed)
+                forEachActiveLine (groupsToRun, numChannels, [n = end - start] (DelayLine& line) { line.beginWindow (n); });
+
+            for (int i = start; i < end; ++i)
+            {
+                const float input = (withDry ? left[i] + right[i] : left[i]) * gain;
+                const float damp = damping.getNextValue();
+                const float feedbck = feedback.getNextValue();
+
+                float outL = 0, outR = 0, totalGroupGain = 0;
+                for (int g = 0; g < groupsToRun; ++g)
+                {
+                    const float groupGain = groupGains[g].getNextValue();
+                    float sumL = 0, sumR = 0;
+                    for (int j = g * combsPerGroup; j < (g + 1) * combsPerGroup; ++j) {
+                        sumL += comb[0][j].template process<Format> (input, damp, feedbck);
+                        sumR += comb[1][j].template process<Format> (input, damp, feedbck);
+                    }
+                    outL += sumL * groupGain;
+                    outR += sumR * groupGain;
+                    totalGroupGain += groupGain;
+                }
+
+                // The comb outputs are uncorrelated, so scale by sqrt(N) to keep the tail energy
+                // independent of how many combs are summed.
+                const float norm = std::sqrt ((float) defaultGroups / totalGroupGain);
+                outL *= norm;
+                outR *= norm;
+
+                for (int j = 0; j < numAllPasses; ++j) {
+                    outL = allPass[0][j].template process<Format> (outL);
+                    outR = allPass[1][j].template process<Format> (outR);
+                }
+
+                const float wet1 = wetGain1.getNextValue();
+                const float wet2 = wetGain2.getNextValue();
+
+                if constexpr (withDry) {
+                    const float dry = dryGain.getNextValue();
+                    left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
+                    right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
+                } else {
+                    left[i]  = outL * wet1 + outR * wet2;
+                    right[i] = outR * wet1 + outL * wet2;
+                }
+            }
+
+            if constexpr (Format::windowed)
+                forEachActiveLine (groupsToRun, numChannels, [n = end - start] (DelayLine& line) { line.endWindow (n); });
+
+            start = end;
+        }
+    }
+
+    template <typename Callback>
+    void forEachDelayLength (double sampleRate, Callback&& callback)
+    {
+        const int intSampleRate = (int) sampleRate;
+
+        for (int i = 0; i < maxGroups * combsPerGroup; ++i) {
+            const bool used = i < allocatedGroups * combsPerGroup;
+            callback (comb[0][i].line, used ? (intSampleRate * combTunings[i]) / 44100 : 0);
+            callback (comb[1][i].line, used ? (intSampleRate * (combTunings[i] + stereoSpread)) / 44100 : 0);
+        }
+
+        for (int i = 0; i < numAllPasses; ++i) {
+            callback (allPass[0][i].line, (intSampleRate * allPassTunings[i]) / 44100);
+            callback (allPass[1][i].line, (intSampleRate * (allPassTunings[i] + stereoSpread)) / 44100);
+        }
+    }
+
+    template <typename Callback>
+    void forEachActiveLine (int groupsToRun, int channelsToRun, Callback&& callback) noexcept
+    {
+        for (int ch = 0; ch < channelsToRun; ++ch) {
+            for (int j = 0; j < groupsToRun * combsPerGroup; ++j) callback (comb[ch][j].line);
+            for (auto& a : allPass[ch])                           callback (a.line);
+        }
+    }
+
+    int getBytesPerSample() const noexcept
+    {
+        return storage == Storage::float16 ? (int) sizeof (Float16::Type) : (int) sizeof (Float32::Type);
+    }
+
+    int getNumGroupsToRun() const noexcept
+    {
+        int groups = numGroups;
+        for (int g = numGroups; g < maxGroups; ++g)
+            if (groupGains[g].isSmoothing())
+                groups = g + 1;
+        return groups;
+    }
+
+    //==============================================================================
+    // One comb's or allpass's memory in either format. A float16 window never spans more than the
+    // line's length, so nothing read inside a window was written inside it.
+    class DelayLine
+    {
+    public:
+        static constexpr int windowCapacity = 32;
+
+        DelayLine() = default;
+
+        void setSize (const int size, const int newBytesPerSample)
+        {
+            if (size == 0) {
+                buffer.free();
+                capacity = bufferSize = bufferIndex = 0;
+                return;
+            }
+
+            if (size != capacity || newBytesPerSample != bytesPerSample) {
+                buffer.malloc ((size_t) size * (size_t) newBytesPerSample);
+                capacity = size;
+                bytesPerSample = newBytesPerSample;
+            }
+            setLength (size);
+        }
+
+        // Shortens the line within the allocated memory.
+        void setLength (const int size) noexcept
+        {
+            bufferSize = juce::jmin (size, capacity);
+            bufferIndex = 0;
+            clear();
+        }
+
+        // All-zero bits are 0.0 in every format, so clearing works on the raw bytes.
+        void clear() noexcept
+        {
+            buffer.clear ((size_t) bufferSize * (size_t) bytesPerSample);
+        }
+
+        int getLength() const noexcept { return bufferSize; }
+        size_t getHeapBytes() const noexcept { return (size_t) capacity * (size_t) bytesPerSample; }
+
+        // The slot to read the delayed sample from and write the new one to, then step on.
+        template <typename Format>
+        float& next() noexcept
+        {
+            if constexpr (Format::windowed) {
+                return window[windowPosition++];
+            } else {
+                float& slot = reinterpret_cast<float*> (buffer.get())[bufferIndex];
+                bufferIndex = (bufferIndex + 1 >= bufferSize) ? 0 : bufferIndex + 1;
+                return slot;
+            }
+        }
+
+        void beginWindow (const int numSamples) noexcept
+        {
+            auto* const data = reinterpret_cast<std::uint16_t*> (buffer.get());
+            const int first = juce::jmin (numSamples, bufferSize - bufferIndex);
+            Float16::toFloat (data + bufferIndex, window, first);
+            Float16::toFloat (data, window + first, numSamples - first);
+            windowPosition = 0;
+        }
+
+        void endWindow (const int numSamples) noexcept
+        {
+            auto* const data = reinterpret_cast<std::uint16_t*> (buffer.get());
+            const int first = juce::jmin (numSamples, bufferSize - bufferIndex);
+            Float16::fromFloat (window, data + bufferIndex, first);
+            Float16::fromFloat (window + first, data, numSamples - first);
+            bufferIndex += numSamples;
+            if (bufferIndex >= bufferSize) bufferIndex -= bufferSize;
+        }
+
+    private:
+        juce::HeapBlock<char> buffer;
+        int capacity = 0, bufferSize = 0, bufferIndex = 0, bytesPerSample = (int) sizeof (float);
+        float window[windowCapacity] {};
+        int windowPosition = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (DelayLine)
+    };
+
+    class CombFilter
+    {
+    public:
+        CombFilter() = default;
+
+        void clear() noexcept
+        {
+            last = 0;
+            line.clear();
+        }
+
+        template <typename Format>
+        float process (const float input, const float damp, const float feedbackLevel) noexcept
+        {
+            float& slot = line.template next<Format>();
+            const float output = slot;
+            last = (output * (1.0f - damp)) + (last * damp);
+            JUCE_UNDENORMALISE (last);
+
+            float temp = input + (last * feedbackLevel);
+            JUCE_UNDENORMALISE (temp);
+            slot = temp;
+            return output;
+        }
+
+        size_t getHeapBytes() const noexcept { return line.getHeapBytes(); }
+
+        DelayLine line;
+        float last = 0.0f;
+
+        JUCE_DECLARE_NON_COPYABLE (CombFilter)
+    };
+
+    class AllPassFilter
+    {
+    public:
+        AllPassFilter() = default;
+
+        void clear() noexcept { line.clear(); }
+
+        template <typename Format>
+        float process (const float input) noexcept
+        {
+            float& slot = line.template next<Format>();
+            const float bufferedValue = slot;
+            float temp = input + (bufferedValue * 0.5f);
+            JUCE_UNDENORMALISE (temp);
+            slot = temp;
+            return bufferedValue - input;
+        }
+
+        size_t getHeapBytes() const noexcept { return line.getHeapBytes(); }
+
+        DelayLine line;
+
+        JUCE_DECLARE_NON_COPYABLE (AllPassFilter)
+    };
+
+    static constexpr int numAllPasses = 4;
+    static constexpr int numChannels = 2;
+
+    // Loop lengths in samples at 44.1 kHz. The first two groups are the stock Freeverb tunings,
+    // interleaved so that a single group still spans the full range of loop lengths.
+    static constexpr short combTunings[maxGroups * combsPerGroup] = { 1116, 1277, 1422, 1557,
+                                                                      1188, 1356, 1491, 1617,
+                                                                      1693, 1759, 1831, 1907 };
+    static constexpr short allPassTunings[numAllPasses] = { 556, 441, 341, 225 };
+    static constexpr int stereoSpread = 23;
+
+    float gain = 0.015f;
+    int numGroups = defaultGroups, allocatedGroups = defaultGroups;
+    double allocatedRate = 44100.0, processingRate = 44100.0;
+    Storage storage = Storage::float32;
+    int windowLength = DelayLine::windowCapacity;
+
+    CombFilter comb[numChannels][maxGroups * combsPerGroup];
+    AllPassFilter allPass[numChannels][numAllPasses];
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+    juce::SmoothedValue<float> groupGains[maxGroups];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RoomReverb)
+};
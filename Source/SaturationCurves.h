@@ -0,0 +1,244 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <iterator>
+#include <cmath>
+
+namespace Saturation
+{
+    // Order must match the "satModel" choice parameter.
+    enum class Model { Classic = 0, Tube, Tape, HardClip, Foldback, numModels };
+
+    inline const juce::StringArray modelNames { "Classic", "Tube", "Tape", "Hard Clip", "Foldback" };
+
+    // Table is the realtime default; Exact evaluates the closed form per sample for offline renders.
+    enum class Quality { Table = 0, Exact, numQualities };
+
+    //==============================================================================
+    // Compile-time maths used to bake the lookup tables. Only ever evaluated by the
+    // compiler, so clarity wins over speed here.
+    namespace detail
+    {
+        constexpr double ln2 = 0.69314718055994530942;
+
+        constexpr double cexp (double x)
+        {
+            int n = (int) (x / ln2 + (x >= 0.0 ? 0.5 : -0.5));
+            double r = x - n * ln2;
+
+            double term = 1.0, sum = 1.0;
+            for (int k = 1; k < 24; ++k) {
+                term *= r / k;
+                sum += term;
+            }
+
+            for (; n > 0; --n) sum *= 2.0;
+            for (; n < 0; ++n) sum *= 0.5;
+            return sum;
+        }
+
+        constexpr double ctanh (double x)
+        {
+            if (x > 20.0)  return 1.0;
+            if (x < -20.0) return -1.0;
+            double e = cexp (2.0 * x);
+            return (e - 1.0) / (e + 1.0);
+        }
+
+        constexpr double cabs (double x) { return x < 0.0 ? -x : x; }
+    }
+
+    //==============================================================================
+    // Shapes that need a transcendental call are baked into tables spanning
+    // [-tableRange, tableRange]; beyond that every curve has fully flattened out.
+    constexpr int   tableSize  = 2049;
+    constexpr float tableRange = 10.0f;
+
+    template <typename Shape>
+    constexpr std::array<float, tableSize> makeTable (Shape shape)
+    {
+        std::array<float, tableSize> table {};
+        for (int i = 0; i < tableSize; ++i) {
+            double x = -tableRange + (2.0 * tableRange * i) / (tableSize - 1);
+            table[(size_t) i] = (float) shape (x);
+        }
+        return table;
+    }
+
+    constexpr double tubeBias = 0.25;
+    constexpr double tapeKnee = 0.5;
+
+    struct Shapes
+    {
+        static constexpr double classic (double x) { return detail::ctanh (x); }
+
+        // Biased tanh: the positive half-wave flattens earlier than the negative one,
+        // which is where the even harmonics come from. Scaled by the negative swing, so the
+        // output settles at -1 and (1 - t) / (1 + t) ~ +0.61 (t = tanh (tubeBias)) and the
+        // slope at 0 is 1 - t ~ 0.76. The DC this leaves behind is removed by DcBlocker.
+        static constexpr double tube (double x)
+        {
+            double t = detail::ctanh (tubeBias);
+            return (detail::ctanh (x + tubeBias) - t) / (1.0 + t);
+        }
+
+        // Clean up to the knee, then a tanh shoulder that lands at +-1.
+        static constexpr double tape (double x)
+        {
+            double mag = detail::cabs (x);
+            if (mag <= tapeKnee) return x;
+            double shaped = tapeKnee + (1.0 - tapeKnee) * detail::ctanh ((mag - tapeKnee) / (1.0 - tapeKnee));
+            return x < 0.0 ? -shaped : shaped;
+        }
+    };
+
+    inline constexpr auto classicTable = makeTable (Shapes::classic);
+    inline constexpr auto tubeTable    = makeTable (Shapes::tube);
+    inline constexpr auto tapeTable    = makeTable (Shapes::tape);
+
+    inline float lookup (const std::array<float, tableSize>& table, float x) noexcept
+    {
+        constexpr float scale = (tableSize - 1) / (2.0f * tableRange);
+        // fmax/fmin rather than jlimit: a NaN compares false against both limits and would reach the
+        // int conversion. This way it lands on -tableRange, as the AVX2 and AVX-512 clamps put it.
+        float pos = (std::fmin (tableRange, std::fmax (-tableRange, x)) + tableRange) * scale;
+        int index = juce::jmin ((int) pos, tableSize - 2);
+        float frac = pos - (float) index;
+        return table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index]);
+    }
+
+    //==============================================================================
+    template <Model M> struct Curve;
+
+    template <> struct Curve<Model::Classic>
+    {
+        static float process (float x) noexcept { return lookup (classicTable, x); }
+        static float exact (float x) noexcept   { return std::tanh (x); }
+    };
+
+    template <> struct Curve<Model::Tube>
+    {
+        static float process (float x) noexcept { return lookup (tubeTable, x); }
+
+        static float exact (float x) noexcept
+        {
+            constexpr float t = (float) detail::ctanh (tubeBias);
+            return (std::tanh (x + (float) tubeBias) - t) / (1.0f + t);
+        }
+    };
+
+    template <> struct Curve<Model::Tape>
+    {
+        static float process (float x) noexcept { return lookup (tapeTable, x); }
+
+        static float exact (float x) noexcept
+        {
+            constexpr float knee = (float) tapeKnee;
+            float mag = std::abs (x);
+            if (mag <= knee) return x;
+            return std::copysign (knee + (1.0f - knee) * std::tanh ((mag - knee) / (1.0f - knee)), x);
+        }
+    };
+
+    // Hard clip at +-1 with a quadratic knee of half-width 0.2 so the corner doesn't alias as badly.
+    template <> struct Curve<Model::HardClip>
+    {
+        static float process (float x) noexcept
+        {
+            constexpr float knee = 0.2f;
+            float mag = std::abs (x);
+            float y = mag;
+            if (mag >= 1.0f + knee)      y = 1.0f;
+            else if (mag > 1.0f - knee)  y = mag - (mag - (1.0f - knee)) * (mag - (1.0f - knee)) / (4.0f * knee);
+            return std::copysign (y, x);
+        }
+
+        static float exact (float x) noexcept { return process (x); }
+    };
+
+    // Triangle fold: anything past +-1 is reflected back towards zero.
+    template <> struct Curve<Model::Foldback>
+    {
+        static float process (float x) noexcept
+        {
+            float t = (x - 1.0f) * 0.25f;
+            t -= std::floor (t);
+            return std::abs (t * 4.0f - 2.0f) - 1.0f;
+        }
+
+        static float exact (float x) noexcept { return process (x); }
+    };
+
+    //==============================================================================
+    template <Model M, Quality Q>
+    void processBlock (float* data, int numSamples, float gain) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if constexpr (Q == Quality::Exact)
+                data[i] = Curve<M>::exact (data[i] * gain);
+            else
+                data[i] = Curve<M>::process (data[i] * gain);
+        }
+    }
+
+    using BlockFunction = void (*) (float*, int, float) noexcept;
+
+    template <Quality Q>
+    constexpr std::array<BlockFunction, (size_t) Model::numModels> makeDispatchRow()
+    {
+        return { &processBlock<Model::Classic, Q>,
+                 &processBlock<Model::Tube, Q>,
+                 &processBlock<Model::Tape, Q>,
+                 &processBlock<Model::HardClip, Q>,
+                 &processBlock<Model::Foldback, Q> };
+    }
+
+    // Picked once per block from the model index, so the sample loop never branches on the model.
+    inline constexpr std::array<BlockFunction, (size_t) Model::numModels> dispatchTable[] =
+    {
+        makeDispatchRow<Quality::Table>(),
+        makeDispatchRow<Quality::Exact>()
+    };
+
+    static_assert (std::size (dispatchTable) == (size_t) Quality::numQualities);
+
+    inline BlockFunction getBlockFunction (int modelIndex, Quality quality = Quality::Table) noexcept
+    {
+        return dispatchTable[(size_t) quality][(size_t) juce::jlimit (0, (int) Model::numModels - 1, modelIndex)];
+    }
+
+    // True for the asymmetric curves, whose output has to go through a DcBlocker.
+    inline bool needsDcBlocker (int modelIndex) noexcept { return modelIndex == (int) Model::Tube; }
+
+    //==============================================================================
+    // One-pole DC blocker, y[n] = x[n] - x[n-1] + R * y[n-1], with its corner at 5 Hz.
+    class DcBlocker
+    {
+    public:
+        void prepare (double sampleRate) noexcept
+        {
+            R = (float) std::exp (-juce::MathConstants<double>::twoPi * 5.0 / sampleRate);
+            reset();
+        }
+
+        void reset() noexcept { x1 = y1 = 0.0f; }
+
+        void process (float* data, int numSamples) noexcept
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float y = data[i] - x1 + R * y1;
+                x1 = data[i];
+                y1 = y;
+                data[i] = y;
+            }
+
+            JUCE_UNDENORMALISE (y1);
+        }
+
+    private:
+        float R = 0.9995f;
+        float x1 = 0.0f, y1 = 0.0f;
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Immutable tables derived from the sample rate. One copy per rate is shared by every plugin
+// instance in the host process; nothing in here may be written after construction.
+struct SharedDspResources
+{
+    // Tone knob positions in 0.25 steps, one table per side of the tilt.
+    static constexpr int toneTableSize = 401;
+
+    explicit SharedDspResources (double rate) : sampleRate (rate)
+    {
+        // Same mappings processBlock used to evaluate per block, kept below Nyquist for low rates.
+        auto prewarp = [rate] (double cutoff) {
+            return (float) std::tan (juce::MathConstants<double>::pi * juce::jmin (cutoff, rate * 0.49) / rate);
+        };
+
+        for (int i = 0; i < toneTableSize; ++i) {
+            const double amount = i / (double) (toneTableSize - 1);
+            lowpassG[(size_t) i]  = prewarp (juce::jmap (amount, 200.0, 20000.0));
+            highpassG[(size_t) i] = prewarp (juce::jmap (amount, 20.0, 2000.0));
+        }
+    }
+
+    // Prewarped SVF coefficient for a tone setting in [-100, 100]. Negative values index the
+    // lowpass table (-100 -> 200 Hz, 0 -> 20 kHz), positive ones the highpass table.
+    float getToneCoefficient (float tone) const noexcept
+    {
+        const auto& table = tone < 0.0f ? lowpassG : highpassG;
+        const float pos = (tone < 0.0f ? tone + 100.0f : tone) * ((toneTableSize - 1) / 100.0f);
+        const int index = juce::jlimit (0, toneTableSize - 2, (int) pos);
+        const float frac = juce::jlimit (0.0f, 1.0f, pos - (float) index);
+        return table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index]);
+    }
+
+    const double sampleRate;
+    std::array<float, toneTableSize> lowpassG {}, highpassG {};
+
+    JUCE_DECLARE_NON_COPYABLE (SharedDspResources)
+};
+
+// Process-wide cache, held through juce::SharedResourcePointer so it lives exactly as long as at
+// least one plugin instance does. Entries are weak, so a rate nobody uses any more is freed with
+// its last user. Only called from prepareToPlay; the audio thread keeps its own shared_ptr.
+class SharedResourceCache
+{
+public:
+    std::shared_ptr<const SharedDspResources> get (double sampleRate)
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+
+        auto& entry = entries[juce::roundToInt (sampleRate)];
+        if (auto existing = entry.lock())
+            return existing;
+
+        auto created = std::make_shared<const SharedDspResources> (sampleRate);
+        entry = created;
+        return created;
+    }
+
+    // Bytes currently held by live shared sets (excluding the constexpr saturation tables, which
+    // live in the binary's read-only data and are shared by the OS already).
+    size_t getLiveBytes()
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+
+        size_t total = 0;
+        for (auto& entry : entries)
+            if (entry.second.lock() != nullptr)
+                total += sizeof (SharedDspResources);
+        return total;
+    }
+
+private:
+    std::mutex mutex;
+    std::map<int, std::weak_ptr<const SharedDspResources>> entries;
+};
+
+// Process-wide message-thread timer that picks up parameter changes for every plugin instance.
+// Parameter listeners can run on the audio thread, where even posting a message may block, so all
+// they do there is bump an atomic generation. One timer then polls every live instance, instead of
+// each one running its own timer or posting its own messages. An instance with nothing new returns
+// after a single atomic load. Held through juce::SharedResourcePointer, like the cache above.
+class ParameterPoller : private juce::Timer
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        // Message thread, every tick. Should return at once when nothing has changed.
+        virtual void pollParameters() = 0;
+    };
+
+    void add (Client& client)
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+        clients.push_back (&client);
+        if (! isTimerRunning()) startTimerHz (pollRateHz);
+    }
+
+    // Waits for a poll in progress, so the client can be destroyed as soon as this returns.
+    void remove (Client& client)
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+        clients.erase (std::remove (clients.begin(), clients.end(), &client), clients.end());
+        if (clients.empty()) stopTimer();
+    }
+
+private:
+    void timerCallback() override
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+        for (auto* client : clients)
+            client->pollParameters();
+    }
+
+    static constexpr int pollRateHz = 100;
+
+    std::mutex mutex;
+    std::vector<Client*> clients;
+};
@@ -0,0 +1,267 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Build with LOUDER_ENABLE_PROFILER=1 to time every processBlock stage. When it is 0 (the default)
+// the profiler member, the macros and the editor overlay all compile away to nothing.
+#ifndef LOUDER_ENABLE_PROFILER
+ #define LOUDER_ENABLE_PROFILER 0
+#endif
+
+// Stage ids. The metering and dry-tap copies get their own ids so they aren't billed to the
+// stages either side of them.
+struct ProfiledStages
+{
+    enum Stage { inputMeter = 0, gain, dryTap, drive, reverb, tone, width, mix, output, limiter, outputMeter, numStages };
+};
+
+#if LOUDER_ENABLE_PROFILER
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+class StageProfiler : public ProfiledStages
+{
+public:
+    // Bucket b counts blocks whose stage cost fell in [2^b, 2^(b+1)) cycles.
+    static constexpr int numBuckets = 32;
+
+    static const char* getStageName (int stage) noexcept
+    {
+        static const char* const names[] = { "Input Meter", "Gain", "Dry Tap", "Drive", "Reverb", "Tone", "Width", "Mix", "Output Gain", "Limiter", "Output Meter" };
+        return juce::isPositiveAndBelow (stage, (int) numStages) ? names[stage] : "";
+    }
+
+    static std::uint64_t now() noexcept
+    {
+       #if JUCE_INTEL
+        return (std::uint64_t) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+        std::uint64_t v;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (v));
+        return v;
+       #else
+        return (std::uint64_t) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    //==============================================================================
+    // Audio thread. Stages may be entered more than once per block; their cost is summed and
+    // committed to the histograms once in endBlock().
+    void beginBlock() noexcept
+    {
+        if (resetRequested.exchange (false, std::memory_order_acquire))
+            for (auto& h : histograms) h.clear();
+
+        for (auto& c : blockCycles) c = 0;
+    }
+
+    void record (Stage stage, std::uint64_t start, std::uint64_t end) noexcept
+    {
+        blockCycles[stage] += end - start;
+
+        if (capturing.load (std::memory_order_relaxed))
+        {
+            const auto scope = traceFifo.write (1);
+            if (scope.blockSize1 > 0)
+                traceEvents[(size_t) scope.startIndex1] = { (std::uint8_t) stage, start, end };
+            else
+                droppedEvents.store (droppedEvents.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    void endBlock() noexcept
+    {
+        for (int s = 0; s < numStages; ++s)
+            if (blockCycles[s] > 0)
+                histograms[s].add (blockCycles[s]);
+    }
+
+    struct Scope
+    {
+        Scope (StageProfiler& p, Stage s) noexcept : profiler (p), stage (s), start (now()) {}
+        ~Scope() noexcept { profiler.record (stage, start, now()); }
+
+        StageProfiler& profiler;
+        Stage stage;
+        std::uint64_t start;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    //==============================================================================
+    // Any thread. Histogram counters have a single writer (the audio thread), so readers may see
+    // a block half-committed; that's fine for a debug overlay.
+    struct StageStats
+    {
+        std::uint64_t blocks = 0, meanCycles = 0, p50Cycles = 0, p99Cycles = 0, maxCycles = 0;
+    };
+
+    StageStats getStats (int stage) const noexcept
+    {
+        StageStats stats;
+        const auto& h = histograms[stage];
+        std::uint32_t counts[numBuckets];
+
+        for (int b = 0; b < numBuckets; ++b) {
+            counts[b] = h.buckets[b].load (std::memory_order_relaxed);
+            stats.blocks += counts[b];
+        }
+
+        if (stats.blocks == 0)
+            return stats;
+
+        stats.meanCycles = h.totalCycles.load (std::memory_order_relaxed) / stats.blocks;
+        stats.maxCycles  = h.maxCycles.load (std::memory_order_relaxed);
+
+        std::uint64_t seen = 0;
+        for (int b = 0; b < numBuckets; ++b) {
+            seen += counts[b];
+            if (stats.p50Cycles == 0 && seen * 2 >= stats.blocks)     stats.p50Cycles = std::uint64_t (1) << (b + 1);
+            if (stats.p99Cycles == 0 && seen * 100 >= stats.blocks * 99) stats.p99Cycles = std::uint64_t (1) << (b + 1);
+        }
+
+        return stats;
+    }
+
+    void requestReset() noexcept { resetRequested.store (true, std::memory_order_release); }
+
+    //==============================================================================
+    // Streams captured events to a Chrome trace (chrome://tracing, Perfetto) from its own thread.
+    class TraceWriter : private juce::Thread
+    {
+    public:
+        TraceWriter (StageProfiler& p, const juce::File& f) : juce::Thread ("LOUDER trace writer"), profiler (p), file (f)
+        {
+            startThread (juce::Thread::Priority::low);
+        }
+
+        ~TraceWriter() override
+        {
+            stopThread (2000);
+        }
+
+        const juce::File& getFile() const noexcept { return file; }
+
+    private:
+        void run() override
+        {
+            file.deleteFile();
+            juce::FileOutputStream out (file);
+            if (! out.openedOk())
+                return;
+
+            // Calibrate counter ticks against the wall clock so "ts" can be written in microseconds.
+            const auto counter0 = now();
+            const auto ticks0   = juce::Time::getHighResolutionTicks();
+            wait (50);
+            const auto counterHz = (double) (now() - counter0)
+                                 / juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - ticks0);
+
+            out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+            bool first = true;
+
+            profiler.droppedEvents.store (0);
+            profiler.capturing.store (true);
+
+            while (! threadShouldExit())
+            {
+                drain (out, counter0, counterHz, first);
+                wait (20);
+            }
+
+            profiler.capturing.store (false);
+            drain (out, counter0, counterHz, first);
+
+            out << "\n],\"otherData\":{\"droppedEvents\":" << juce::String ((juce::int64) profiler.droppedEvents.load()) << "}}\n";
+            out.flush();
+        }
+
+        void drain (juce::FileOutputStream& out, std::uint64_t origin, double counterHz, bool& first)
+        {
+            const auto scope = profiler.traceFifo.read (profiler.traceFifo.getNumReady());
+
+            auto writeRange = [&] (int start, int size)
+            {
+                for (int i = start; i < start + size; ++i)
+                {
+                    const auto& e = profiler.traceEvents[(size_t) i];
+                    const double ts  = (double) (std::int64_t) (e.start - origin) * 1.0e6 / counterHz;
+                    const double dur = (double) (e.end - e.start) * 1.0e6 / counterHz;
+
+                    out << (first ? "" : ",\n")
+                        << "{\"name\":\"" << getStageName (e.stage) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+                        << juce::String (ts, 3) << ",\"dur\":" << juce::String (dur, 3) << "}";
+                    first = false;
+                }
+            };
+
+            writeRange (scope.startIndex1, scope.blockSize1);
+            writeRange (scope.startIndex2, scope.blockSize2);
+        }
+
+        StageProfiler& profiler;
+        juce::File file;
+
+        JUCE_DECLARE_NON_COPYABLE (TraceWriter)
+    };
+
+private:
+    struct Histogram
+    {
+        std::atomic<std::uint32_t> buckets[numBuckets] {};
+        std::atomic<std::uint64_t> totalCycles { 0 }, maxCycles { 0 };
+
+        // Single writer, so plain load/store avoids locked read-modify-write instructions.
+        void add (std::uint64_t cycles) noexcept
+        {
+            const int b = juce::findHighestSetBit ((juce::uint32) juce::jmin (cycles, (std::uint64_t) 0xffffffffu));
+            buckets[b].store (buckets[b].load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            totalCycles.store (totalCycles.load (std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+            if (cycles > maxCycles.load (std::memory_order_relaxed))
+                maxCycles.store (cycles, std::memory_order_relaxed);
+        }
+
+        void clear() noexcept
+        {
+            for (auto& b : buckets) b.store (0, std::memory_order_relaxed);
+            totalCycles.store (0, std::memory_order_relaxed);
+            maxCycles.store (0, std::memory_order_relaxed);
+        }
+    };
+
+    struct TraceEvent
+    {
+        std::uint8_t stage;
+        std::uint64_t start, end;
+    };
+
+    static constexpr int traceCapacity = 1 << 16;
+
+    Histogram histograms[numStages];
+    std::uint64_t blockCycles[numStages] {};
+    std::atomic<bool> resetRequested { false };
+
+    juce::AbstractFifo traceFifo { traceCapacity };
+    std::array<TraceEvent, (size_t) traceCapacity> traceEvents {};
+    std::atomic<bool> capturing { false };
+    std::atomic<std::uint64_t> droppedEvents { 0 };
+};
+
+ #define LOUDER_PROFILE_STAGE(profiler, stage) StageProfiler::Scope JUCE_JOIN_MACRO (profileScope_, __LINE__) (profiler, StageProfiler::stage)
+ #define LOUDER_PROFILE_STAGE_ID(profiler, id)  StageProfiler::Scope JUCE_JOIN_MACRO (profileScope_, __LINE__) (profiler, id)
+ #define LOUDER_PROFILE_BEGIN_BLOCK(profiler)  (profiler).beginBlock()
+ #define LOUDER_PROFILE_END_BLOCK(profiler)    (profiler).endBlock()
+
+#else
+
+ #define LOUDER_PROFILE_STAGE(profiler, stage)
+ #define LOUDER_PROFILE_STAGE_ID(profiler, id)
+ #define LOUDER_PROFILE_BEGIN_BLOCK(profiler)
+ #define LOUDER_PROFILE_END_BLOCK(profiler)
+
+#endif
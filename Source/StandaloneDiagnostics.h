@@ -0,0 +1,196 @@
+#pragma once
+#include <JuceHeader.h>
+#include "CallbackMonitor.h"
+
+#if JucePlugin_Build_Standalone
+ #include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+#endif
+
+// The standalone app's audio readout: the device and buffer size actually in use, the callback
+// monitor's load histogram, overrun/late/xrun counts and how the audio thread is scheduled. The
+// editor only creates it in the standalone app. It also writes a summary line every ten seconds, and
+// whenever the device settings change, to StandaloneDiagnostics.log in the platform's log folder
+// (~/Library/Logs, ~/.config or %APPDATA%), so a sound-check run can be read back afterwards.
+// Clicking the panel resets the statistics.
+class StandaloneDiagnostics : public juce::Component, private juce::Timer
+{
+public:
+    static constexpr int logIntervalSeconds = 10;
+
+    explicit StandaloneDiagnostics (CallbackMonitor& m) : monitor (m)
+    {
+        logger.reset (juce::FileLogger::createDefaultAppLogger ("LOUDER Saturator", "StandaloneDiagnostics.log",
+                                                                "a LOUDER Saturator standalone diagnostics"));
+        startTimerHz (4);
+    }
+
+    ~StandaloneDiagnostics() override
+    {
+        stopTimer();
+        writeLog ("closed");
+    }
+
+    juce::File getLogFile() const { return logger != nullptr ? logger->getLogFile() : juce::File(); }
+
+    void mouseDown (const juce::MouseEvent&) override
+    {
+        monitor.requestReset();
+        writeLog ("reset");
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat();
+        g.setColour (juce::Colour (0xE01A1A1A));
+        g.fillRoundedRectangle (bounds, 4.0f);
+        g.setColour (juce::Colour (0xFF3A3A3A));
+        g.drawRoundedRectangle (bounds.reduced (1.0f), 4.0f, 2.0f);
+
+        auto area = getLocalBounds().reduced (12);
+        g.setFont (juce::FontOptions (11.0f).withStyle ("Bold"));
+        g.setColour (juce::Colour (0xFF0087FF));
+        g.drawText ("AUDIO CALLBACK", area.removeFromTop (20), juce::Justification::centredLeft);
+
+        auto percent = [] (float load) { return juce::String (juce::roundToInt (load * 100.0f)) + "%"; };
+        const auto blockSizes = stats.minBlockSize == stats.maxBlockSize ? juce::String (stats.maxBlockSize)
+                                                                         : juce::String (stats.minBlockSize) + "-" + juce::String (stats.maxBlockSize);
+        const double budgetMs = stats.sampleRate > 0.0 ? 1000.0 * stats.maxBlockSize / stats.sampleRate : 0.0;
+
+        const std::pair<const char*, juce::String> rows[] = {
+            { "DEVICE",    device.name.isEmpty() ? juce::String ("none") : device.type + " / " + device.name },
+            { "BUFFER",    juce::String (device.bufferSize) + " smp @ " + juce::String (device.sampleRate, 0) + " Hz, latency in "
+                             + juce::String (device.inputLatency) + " / out " + juce::String (device.outputLatency) + " smp" },
+            { "CALLBACKS", juce::String ((juce::int64) stats.callbacks) + " calls of " + blockSizes + " smp, budget " + juce::String (budgetMs, 2) + " ms" },
+            { "LOAD",      "mean " + percent (stats.meanLoad) + "   p50 " + percent (stats.p50Load) + "   p99 " + percent (stats.p99Load)
+                             + "   max " + percent (stats.maxLoad) + "   device CPU " + percent ((float) device.cpuUsage) },
+            { "DROPOUTS",  juce::String ((juce::int64) stats.overruns) + " overruns   " + juce::String ((juce::int64) stats.late) + " late (worst gap "
+                             + juce::String (stats.worstIntervalPeriods, 2) + " periods)   "
+                             + (device.xruns >= 0 ? juce::String (device.xruns) + " device xruns" : juce::String ("device xruns n/a")) },
+            { "THREAD",    CallbackMonitor::describe (thread) }
+        };
+
+        g.setFont (juce::FontOptions (11.0f));
+        for (const auto& [label, value] : rows)
+        {
+            auto row = area.removeFromTop (18);
+            g.setColour (juce::Colours::grey);
+            g.drawText (label, row.removeFromLeft (80), juce::Justification::centredLeft);
+            g.setColour (juce::Colour (0xFFE0E0E0));
+            g.drawText (value, row, juce::Justification::centredLeft);
+        }
+
+        g.setColour (juce::Colours::grey);
+        g.drawText ("CLICK TO RESET" + (getLogFile() != juce::File() ? "   LOG: " + getLogFile().getFullPathName() : juce::String()),
+                    area.removeFromBottom (18), juce::Justification::centredLeft);
+
+        // One column per 5% of the budget, heights log-scaled so single overruns stay visible.
+        auto axis = area.removeFromBottom (16);
+        area.removeFromTop (10);
+        auto plot = area.toFloat();
+        const float columnWidth = plot.getWidth() / (float) CallbackMonitor::numBuckets;
+
+        std::uint32_t largest = 1;
+        for (auto count : stats.buckets) largest = juce::jmax (largest, count);
+
+        g.setColour (juce::Colour (0xFF2D2D2D));
+        g.fillRect (plot);
+
+        for (int b = 0; b < CallbackMonitor::numBuckets; ++b)
+        {
+            const auto count = stats.buckets[(size_t) b];
+            if (count == 0)
+                continue;
+
+            const float height = plot.getHeight() * (float) (std::log2 (count + 1.0) / std::log2 (largest + 1.0));
+            g.setColour (b >= CallbackMonitor::bucketsPerBudget ? juce::Colour (0xFFE53935) : juce::Colour (0xFF4DB8FF));
+            g.fillRect (plot.getX() + b * columnWidth + 1.0f, plot.getBottom() - height, columnWidth - 2.0f, height);
+        }
+
+        const float deadlineX = plot.getX() + CallbackMonitor::bucketsPerBudget * columnWidth;
+        g.setColour (juce::Colour (0xFFE53935));
+        g.drawVerticalLine (juce::roundToInt (deadlineX), plot.getY(), plot.getBottom());
+
+        g.setColour (juce::Colours::grey);
+        g.drawText ("0%", axis.withWidth (40), juce::Justification::centredLeft);
+        g.drawText ("100% (DEADLINE)", juce::Rectangle<int> (juce::roundToInt (deadlineX) - 60, axis.getY(), 120, axis.getHeight()), juce::Justification::centred);
+        g.drawText ("200%+", axis.removeFromRight (40), juce::Justification::centredRight);
+    }
+
+private:
+    struct DeviceInfo
+    {
+        juce::String type, name;
+        int bufferSize = 0, inputLatency = 0, outputLatency = 0, xruns = -1;
+        double sampleRate = 0.0, cpuUsage = 0.0;
+
+        bool sameSettings (const DeviceInfo& other) const
+        {
+            return type == other.type && name == other.name && bufferSize == other.bufferSize && sampleRate == other.sampleRate;
+        }
+    };
+
+    // Message thread only: the holder is found through the desktop's top-level windows.
+    static DeviceInfo getDeviceInfo()
+    {
+        DeviceInfo info;
+       #if JucePlugin_Build_Standalone
+        if (auto* holder = juce::StandalonePluginHolder::getInstance())
+        {
+            if (auto* audioDevice = holder->deviceManager.getCurrentAudioDevice())
+            {
+                info.type = audioDevice->getTypeName();
+                info.name = audioDevice->getName();
+                info.bufferSize = audioDevice->getCurrentBufferSizeSamples();
+                info.sampleRate = audioDevice->getCurrentSampleRate();
+                info.inputLatency = audioDevice->getInputLatencyInSamples();
+                info.outputLatency = audioDevice->getOutputLatencyInSamples();
+                info.xruns = holder->deviceManager.getXRunCount();
+                info.cpuUsage = holder->deviceManager.getCpuUsage();
+            }
+        }
+       #endif
+        return info;
+    }
+
+    void timerCallback() override
+    {
+        const auto previous = device;
+        device = getDeviceInfo();
+        stats = monitor.getStats();
+        thread = monitor.getThreadInfo();
+
+        if (! device.sameSettings (previous))
+            writeLog ("device " + (device.name.isEmpty() ? juce::String ("closed") : device.type + " / " + device.name + ", "
+                                     + juce::String (device.bufferSize) + " smp @ " + juce::String (device.sampleRate, 0) + " Hz"));
+
+        if (++ticksSinceLog >= logIntervalSeconds * 4 && stats.callbacks > 0)
+            writeLog ("stats");
+
+        if (isVisible())
+            repaint();
+    }
+
+    void writeLog (const juce::String& event)
+    {
+        ticksSinceLog = 0;
+        if (logger == nullptr)
+            return;
+
+        auto line = juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H:%M:%S ") + event;
+        if (stats.callbacks > 0)
+            line << ": " << CallbackMonitor::summarise (stats) << ", "
+                 << (device.xruns >= 0 ? juce::String (device.xruns) : juce::String ("n/a")) << " device xruns, "
+                 << "device CPU " << juce::roundToInt (device.cpuUsage * 100.0) << "%, thread " << CallbackMonitor::describe (thread);
+        logger->logMessage (line);
+    }
+
+    CallbackMonitor& monitor;
+    std::unique_ptr<juce::FileLogger> logger;
+
+    DeviceInfo device;
+    CallbackMonitor::Stats stats;
+    CallbackMonitor::ThreadInfo thread;
+    int ticksSinceLog = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (StandaloneDiagnostics)
+};
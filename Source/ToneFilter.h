@@ -0,0 +1,50 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Single-channel TPT state-variable filter: the same topology and maths as
+// juce::dsp::StateVariableTPTFilter at its default resonance, but it takes the prewarped
+// coefficient directly so the tan() can come from a shared table instead of the audio thread.
+class ToneFilter
+{
+public:
+    enum class Type { lowpass, highpass };
+
+    void setType (Type newType) noexcept { type = newType; }
+
+    // g = tan (pi * cutoff / sampleRate)
+    void setCoefficient (float newG) noexcept
+    {
+        g = newG;
+        h = 1.0f / (1.0f + R2 * g + g * g);
+    }
+
+    void reset() noexcept { s1 = s2 = 0.0f; }
+
+    void process (float* data, int numSamples) noexcept
+    {
+        if (type == Type::lowpass) processBlock<Type::lowpass> (data, numSamples);
+        else                       processBlock<Type::highpass> (data, numSamples);
+    }
+
+private:
+    template <Type T>
+    void processBlock (float* data, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float yHP = h * (data[i] - s1 * (g + R2) - s2);
+            const float yBP = yHP * g + s1;
+            s1 = yHP * g + yBP;
+            const float yLP = yBP * g + s2;
+            s2 = yBP * g + yLP;
+
+            data[i] = T == Type::lowpass ? yLP : yHP;
+        }
+    }
+
+    static constexpr float R2 = juce::MathConstants<float>::sqrt2;
+
+    Type type = Type::lowpass;
+    float g = 0.0f, h = 1.0f;
+    float s1 = 0.0f, s2 = 0.0f;
+};